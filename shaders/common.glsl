@@ -0,0 +1,711 @@
+// Scene bindings and ray tracing functions shared by the megakernel and the wavefront kernels.
+// Includers enable GL_KHR_shader_subgroup_arithmetic for CountRays().
+
+/////////// Constants ///////////
+#define MAX_BOUNCES 16 // MAX_BOUNCES in ComputeData.h
+#define FLT_MAX 3.402823466e+38
+#define FLT_MIN 1.175494351e-38
+#define EPSILON 1e-4
+#define PI 3.14159265359
+#define SHADOW_EPSILON 1e-3 // Relative, shadow rays stop this much short of the light they were aimed at
+#define ADAPTIVE_TILE_SIZE 16 // ADAPTIVE_TILE_SIZE in ComputeData.h
+
+// Values of the adaptiveSampling push constant
+#define ADAPTIVE_OFF 0   // Every pixel holds sampleIndex samples, pixel stats are left untouched
+#define ADAPTIVE_STATS 1 // Pixel stats are accumulated, the mask is not built yet
+#define ADAPTIVE_MASK 2  // Tiles take their samples from the mask
+
+/////////// Structs ///////////
+struct Ray {
+    vec3 ori;
+    vec3 dir;
+};
+
+struct Material {
+    vec3 color;
+    float smoothness;
+    vec3 emissionColor;
+    float emissionStrength;
+};
+
+struct Sphere {
+    vec3 pos;
+    float rad;
+    Material mat;
+};
+
+struct Triangle {
+    vec3 a, b, c;
+};
+
+struct BoundingBox {
+    vec3 min, max;
+};
+
+struct Mesh {
+    uint start;
+    Material mat;
+};
+
+struct Light {
+    uint primitive; // Sphere index, or triangle index for mesh lights
+    uint material;  // Index for GetMaterial()
+    float cdf;      // Normalized power of the lights up to this one included
+};
+
+struct BVH_Node {
+    BoundingBox bbox;
+
+    uint left;
+    uint right;
+
+    uint start;
+    uint count;
+};
+
+struct PixelStats {
+    float lumSquared; // Mean of the squared luminance of the samples
+    uint samples;
+};
+
+struct HitInfo {
+    bool didCollide;
+    float dst;
+    vec3 hitPoint;
+    vec3 normal;
+    Material mat;
+    uint material; // Index for GetMaterial()
+    uint triangle; // Mesh hits only
+};
+
+/////////// Uniforms ///////////
+layout (push_constant) uniform PushData {
+    uint sampleIndex;        // Samples accumulated before this dispatch, 0 restarts the accumulation
+    uint samplesPerDispatch; // Megakernel only, the wavefront integrator is dispatched once per sample
+    uint maxBounces;
+    uint bounce;   // Wavefront stage being dispatched
+    uint sortRays; // Extend reads its queue in sorted order
+    uint sortPass; // Radix sort pass being dispatched
+    uint rouletteDepth; // Bounces before Russian roulette starts, 0 disables it
+    uint lightSampling; // Next-event estimation on diffuse hits, weighted against bounces into the lights
+    uint sampleSequence; // SampleSequence of RenderSettings.h, see NextSample()
+    uint adaptiveSampling; // ADAPTIVE_OFF, ADAPTIVE_STATS, or ADAPTIVE_MASK once adaptive_mask.comp built one
+    float adaptiveThreshold; // Relative error under which a tile has converged
+    uint adaptiveMinSamples; // Per pixel, before their error is trusted
+    uint imageWidth;  // Pixels of the accumulation buffer, see ImageSize()
+    uint imageHeight;
+    uint toneMapping; // resolve.comp only, filmic curve instead of a clamp
+    uint tileCount;   // main.comp only, tiles of the scheduler's list, 0 dispatches the whole image
+};
+
+/////////// Specialization ///////////
+// Baked into each megakernel variant by ComputePipeline, the defaults make the generic kernels
+layout (constant_id = 0) const uint SPEC_BOUNCES = 0; // 0 reads maxBounces from the push constants
+layout (constant_id = 1) const uint BVH_STACK_SIZE = 32;
+layout (constant_id = 2) const float AA_RATIO = 1e-3;
+layout (constant_id = 3) const bool ENABLE_SPHERES = true;
+layout (constant_id = 4) const bool ENABLE_MESHES = true;
+
+layout (set = 0, binding = 0, std430) buffer Accumulation {
+    float accumulation[]; // Running mean of every pixel, packed RGB rows, see StorePixel()
+};
+
+layout (set = 0, binding = 1, std140) uniform CameraData {
+    vec3 cameraPosition;
+    vec3 cameraForward;
+    vec3 cameraRight;
+    vec3 cameraUp;
+    float fov;
+};
+
+layout (set = 0, binding = 2, std140) uniform SceneData {
+    uint numTriangles;
+    uint numSpheres;
+    uint numMeshes;
+    uint bvhDepth;
+    vec3 boundsMin;
+    vec3 boundsMax;
+    uint numLights;
+    float lightPower; // Summed LightPower() of the lights
+};
+
+layout (set = 0, binding = 3, std430) buffer Meshes {
+    Mesh meshes[];
+};
+
+layout (set = 0, binding = 4, std430) buffer Triangles {
+    Triangle triangles[];
+};
+
+layout (set = 0, binding = 5, std430) buffer BVH_Nodes {
+    BVH_Node nodes[];
+};
+
+layout (set = 0, binding = 6, std430) buffer Spheres {
+    Sphere spheres[];
+};
+
+layout (set = 0, binding = 7, std430) buffer RayStats {
+    uint rayCountLow;
+    uint rayCountHigh;
+};
+
+layout (set = 0, binding = 16, std430) buffer Lights {
+    Light lights[];
+};
+
+layout (set = 0, binding = 17, std430) buffer PixelStatsBuffer {
+    PixelStats pixelStats[];
+};
+
+layout (set = 0, binding = 18, std430) buffer TileMask {
+    uint tileSamples[]; // Samples of each tile in the next dispatch, 0 once converged
+};
+
+/////////// Helpers ///////////
+uint MaxBounces() {
+    return SPEC_BOUNCES != 0 ? SPEC_BOUNCES : maxBounces;
+}
+
+uint WangHash(uint seed) {
+    seed = (seed ^ 61u) ^ (seed >> 16u);
+    seed *= 9u;
+    seed = seed ^ (seed >> 4u);
+    seed *= 0x27d4eb2du;
+    seed = seed ^ (seed >> 15u);
+    return seed;
+}
+
+float RandomFloat01(inout uint state) {
+    state = WangHash(state);
+    return float(state & 0x00FFFFFFu) / float(0x01000000u);
+}
+
+/////////// Sampling ///////////
+#define SEQUENCE_WHITE_NOISE 0 // SampleSequence of RenderSettings.h
+#define SEQUENCE_SOBOL 1
+#define BOUNCE_DIMENSIONS 4 // Light selection, point on the light, BSDF direction, roulette
+
+// Random numbers of one pixel sample. White noise comes from the seed alone, the Sobol sequence
+// gives each dimension pair its own Owen scrambling of the same (0, 2)-sequence, seeded per pixel.
+struct SampleStream {
+    uint seed;
+    uint pixel;
+    uint index;     // Sample of the pixel, from 0
+    uint dimension; // Next dimension pair
+};
+
+SampleStream StartSample(uint pixel, uint index) {
+    // Seeds start at sample 1, like the CPU renderer's ones
+    return SampleStream(pixel + (index + 1) * 41848451, pixel, index, 0);
+}
+
+// Dimensions are numbered per bounce, so every integrator draws the same ones at the same bounce
+void StartBounce(inout SampleStream stream, uint bounce) {
+    stream.dimension = 1 + bounce * BOUNCE_DIMENSIONS;
+}
+
+// Laine-Karras permutation on reversed bits, a nested uniform scramble. Burley 2020
+uint OwenScramble(uint x, uint seed) {
+    x = bitfieldReverse(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return bitfieldReverse(x);
+}
+
+// Second dimension of the Sobol sequence, the first one is the bit reversal of the index
+uint Sobol1(uint index) {
+    uint result = 0;
+    for (uint v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1) {
+        if ((index & 1u) != 0) result ^= v;
+    }
+    return result;
+}
+
+vec2 SobolOwen(uint index, uint seed) {
+    // Scrambling the index too shuffles the order of the points, not only their positions
+    index = OwenScramble(index, seed);
+    uint x = OwenScramble(bitfieldReverse(index), WangHash(seed ^ 1u));
+    uint y = OwenScramble(Sobol1(index), WangHash(seed ^ 2u));
+    return vec2(x >> 8, y >> 8) / float(0x01000000u);
+}
+
+vec2 NextSample2D(inout SampleStream stream) {
+    uint dimension = stream.dimension++;
+    if (sampleSequence == SEQUENCE_SOBOL) return SobolOwen(stream.index, WangHash(stream.pixel ^ WangHash(dimension)));
+
+    float x = RandomFloat01(stream.seed);
+    float y = RandomFloat01(stream.seed);
+    return vec2(x, y);
+}
+
+// Takes a whole dimension pair, the sequences stay aligned whatever the caller draws
+float NextSample(inout SampleStream stream) {
+    if (sampleSequence == SEQUENCE_SOBOL) return NextSample2D(stream).x;
+
+    stream.dimension++;
+    return RandomFloat01(stream.seed);
+}
+
+// Orthonormal basis around a unit vector, Duff et al. 2017
+void Basis(vec3 n, out vec3 tangent, out vec3 bitangent) {
+    float s = n.z >= 0.0 ? 1.0 : -1.0;
+    float a = -1.0 / (s + n.z);
+    float b = n.x * n.y * a;
+    tangent = vec3(1.0 + s * n.x * n.x * a, s * b, -s * n.x);
+    bitangent = vec3(b, s + n.y * n.y * a, -n.y);
+}
+
+// Density cos / PI around the normal, the one light sampling is weighted against
+vec3 CosineSampleHemisphere(vec3 normal, vec2 u) {
+    float r = sqrt(u.x);
+    float phi = 2.0 * PI * u.y;
+
+    vec3 tangent, bitangent;
+    Basis(normal, tangent, bitangent);
+    return normalize(r * cos(phi) * tangent + r * sin(phi) * bitangent + sqrt(max(1.0 - u.x, 0.0)) * normal);
+}
+
+// Russian roulette after `depth` bounces: dim paths stop early, survivors are reweighted to stay unbiased
+bool SurvivesRoulette(uint depth, inout vec3 throughput, inout SampleStream stream) {
+    if (rouletteDepth == 0 || depth < rouletteDepth) return true;
+
+    float survival = min(max(throughput.r, max(throughput.g, throughput.b)), 0.95);
+    if (NextSample(stream) >= survival) return false;
+
+    throughput /= survival;
+    return true;
+}
+
+float Luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+ivec2 ImageSize() {
+    return ivec2(imageWidth, imageHeight);
+}
+
+vec3 LoadAccumulation(uint pixel) {
+    return vec3(accumulation[pixel * 3], accumulation[pixel * 3 + 1], accumulation[pixel * 3 + 2]);
+}
+
+// Samples already accumulated in the pixel, also the index of its next one
+uint PixelSamples(uint pixel) {
+    if (sampleIndex == 0) return 0;
+    return adaptiveSampling == ADAPTIVE_OFF ? sampleIndex : pixelStats[pixel].samples;
+}
+
+// Samples of the pixel in this dispatch
+uint TileSamples(ivec2 coord) {
+    if (adaptiveSampling != ADAPTIVE_MASK) return samplesPerDispatch;
+
+    uint tilesX = (imageWidth + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+    return tileSamples[coord.y / ADAPTIVE_TILE_SIZE * tilesX + coord.x / ADAPTIVE_TILE_SIZE];
+}
+
+// Adds the sums of new samples to the running means of the pixel, with a single write of 12 bytes.
+// The stats are only touched while adaptive sampling needs them.
+void StorePixel(ivec2 coord, vec3 colorSum, float lumSquaredSum, uint samples) {
+    uint pixel = coord.y * imageWidth + coord.x;
+    uint count = PixelSamples(pixel);
+
+    vec3 prev = count == 0 ? vec3(0.0) : LoadAccumulation(pixel);
+    float total = float(count + samples);
+
+    vec3 mean = (prev * float(count) + colorSum) / total;
+    accumulation[pixel * 3] = mean.r;
+    accumulation[pixel * 3 + 1] = mean.g;
+    accumulation[pixel * 3 + 2] = mean.b;
+
+    if (adaptiveSampling == ADAPTIVE_OFF) return;
+
+    float prevSquared = count == 0 ? 0.0 : pixelStats[pixel].lumSquared;
+    pixelStats[pixel] = PixelStats((prevSquared * float(count) + lumSquaredSum) / total, count + samples);
+}
+
+/////////// Core ///////////
+HitInfo RaySphereIntersection(Ray ray, const Sphere sphere) {
+    HitInfo hitInfo;
+    hitInfo.didCollide = false;
+
+    vec3 offsetRayOrigin = ray.ori - sphere.pos;
+    float a = dot(ray.dir, ray.dir);
+    float b = 2.0 * dot(offsetRayOrigin, ray.dir);
+    float c = dot(offsetRayOrigin, offsetRayOrigin) - sphere.rad * sphere.rad;
+    float discriminant = b * b - 4.0 * a * c;
+
+    if (discriminant >= 0.0) {
+        float dst = (-b - sqrt(discriminant)) / (2.0 * a);
+        if (dst >= 0.0) {
+            hitInfo.didCollide = true;
+            hitInfo.dst = dst;
+            hitInfo.hitPoint = ray.ori + dst * ray.dir;
+            hitInfo.normal = normalize(hitInfo.hitPoint - sphere.pos);
+            hitInfo.mat = sphere.mat;
+        }
+    }
+    return hitInfo;
+}
+
+HitInfo RayTriangleIntersection(Ray ray, const Triangle triangle) {
+    vec3 ab = triangle.b - triangle.a;
+    vec3 ac = triangle.c - triangle.a;
+    vec3 normal = cross(ab, ac);
+    vec3 ao = ray.ori - triangle.a;
+    vec3 dao = cross(ao, ray.dir);
+
+    float determinant = -dot(ray.dir, normal);
+    float invDet = 1 / determinant;
+
+    float dst = dot(ao, normal) * invDet;
+    float u = dot(ac, dao) * invDet;
+    float v = -dot(ab, dao) * invDet;
+    float w = 1 - u - v;
+
+    HitInfo hitInfo;
+    hitInfo.didCollide = determinant >= 1E-6 && dst >= 0 && u >= 0 && v >= 0 && w >= 0;
+    hitInfo.hitPoint = ray.ori + ray.dir * dst;
+    hitInfo.normal = normalize(normal);
+    hitInfo.dst = dst;
+    return hitInfo;
+}
+
+// https://gist.github.com/DomNomNom/46bb1ce47f68d255fd5d
+bool RayBoundingBoxIntersection(Ray ray, const vec3 boxMin, const vec3 boxMax) {
+    vec3 tMin = (boxMin - ray.ori) / ray.dir;
+    vec3 tMax = (boxMax - ray.ori) / ray.dir;
+    vec3 t1 = min(tMin, tMax);
+    vec3 t2 = max(tMin, tMax);
+    float tNear = max(max(t1.x, t1.y), t1.z);
+    float tFar = min(min(t2.x, t2.y), t2.z);
+
+    return tNear <= tFar;
+}
+
+HitInfo RayBVHIntersection(Ray ray, Material mat, uint startIndex) {
+    HitInfo closest;
+    closest.didCollide = false;
+    closest.dst = FLT_MAX;
+
+    uint stack[BVH_STACK_SIZE];
+    uint stackTopIndex = 0;
+    stack[stackTopIndex++] = startIndex;
+
+    while (stackTopIndex != 0) {
+        BVH_Node currentNode = nodes[stack[--stackTopIndex]];
+
+        if (currentNode.left == 0 && currentNode.right == 0) {
+            for (uint t = currentNode.start; t < currentNode.start + currentNode.count; t++) {
+                HitInfo current = RayTriangleIntersection(ray, triangles[t]);
+                if (current.didCollide && current.dst < closest.dst) {
+                    closest = current;
+                    closest.triangle = t;
+                }
+            }
+        } else if (RayBoundingBoxIntersection(ray, currentNode.bbox.min, currentNode.bbox.max)) {
+            stack[stackTopIndex++] = currentNode.left;
+            stack[stackTopIndex++] = currentNode.right;
+        }
+    }
+
+    // Triangle hits carry no material, copying them overwrote the mesh one
+    closest.mat = mat;
+    return closest;
+};
+
+Ray GenerateRay(ivec2 pixelCoord, inout SampleStream stream) {
+    ivec2 size = ImageSize();
+    vec2 uv = (vec2(pixelCoord) + 0.5) / size;
+    vec2 screen = uv * 2.0 - 1.0;
+    screen.x *= size.x / size.y;
+
+    float focalLength = 1.0 / tan(fov * 0.5);
+    vec3 rayDir = normalize(screen.x * cameraRight + screen.y * cameraUp + focalLength * cameraForward);
+
+    // Anti-aliasing
+    vec2 jitter = NextSample2D(stream) * 2.0 - 1.0;
+    rayDir += (jitter.x * cameraRight + jitter.y * cameraUp) * AA_RATIO;
+
+    return Ray(cameraPosition, rayDir);
+}
+
+HitInfo ClosestHit(Ray ray) {
+    HitInfo closest;
+    closest.didCollide = false;
+    closest.dst = FLT_MAX;
+
+    // Spheres
+    if (ENABLE_SPHERES) {
+        for (int j = 0; j < numSpheres; j++) {
+            HitInfo current = RaySphereIntersection(ray, spheres[j]);
+            if (current.didCollide && current.dst < closest.dst) {
+                closest = current;
+                closest.material = uint(j);
+            }
+        }
+    }
+
+    // Single BVH Mesh
+    if (ENABLE_MESHES) {
+        for (int i = 0; i < numMeshes; i++) {
+            const Mesh m = meshes[i];
+            HitInfo current = RayBVHIntersection(ray, m.mat, m.start);
+            if (current.didCollide && current.dst < closest.dst) {
+                closest = current;
+                closest.material = numSpheres + uint(i);
+            }
+        }
+    }
+
+    return closest;
+}
+
+Material GetMaterial(uint index) {
+    return index < numSpheres ? spheres[index].mat : meshes[index - numSpheres].mat;
+}
+
+/////////// Occlusion ///////////
+// Visibility only: no hit point, normal or material, and every test is bounded by tMax
+
+bool RaySphereOccludes(Ray ray, Sphere sphere, float tMax) {
+    vec3 offsetRayOrigin = ray.ori - sphere.pos;
+    float a = dot(ray.dir, ray.dir);
+    float b = 2.0 * dot(offsetRayOrigin, ray.dir);
+    float c = dot(offsetRayOrigin, offsetRayOrigin) - sphere.rad * sphere.rad;
+    float discriminant = b * b - 4.0 * a * c;
+    if (discriminant < 0.0) return false;
+
+    // Near root only, as RaySphereIntersection(): origins inside a sphere do not see it
+    float dst = (-b - sqrt(discriminant)) / (2.0 * a);
+    return dst >= 0.0 && dst < tMax;
+}
+
+bool RayTriangleOccludes(Ray ray, Triangle triangle, float tMax) {
+    vec3 ab = triangle.b - triangle.a;
+    vec3 ac = triangle.c - triangle.a;
+    vec3 normal = cross(ab, ac);
+
+    float determinant = -dot(ray.dir, normal);
+    if (determinant < 1E-6) return false;
+
+    vec3 ao = ray.ori - triangle.a;
+    float invDet = 1 / determinant;
+    float dst = dot(ao, normal) * invDet;
+    if (dst < 0 || dst >= tMax) return false;
+
+    vec3 dao = cross(ao, ray.dir);
+    float u = dot(ac, dao) * invDet;
+    float v = -dot(ab, dao) * invDet;
+    return u >= 0 && v >= 0 && u + v <= 1;
+}
+
+// Slab test of the [0, tMax] segment, boxes behind the origin or past tMax are skipped
+bool RayBoundingBoxOverlaps(vec3 ori, vec3 invDir, const vec3 boxMin, const vec3 boxMax, float tMax) {
+    vec3 tLow = (boxMin - ori) * invDir;
+    vec3 tHigh = (boxMax - ori) * invDir;
+    vec3 t1 = min(tLow, tHigh);
+    vec3 t2 = max(tLow, tHigh);
+    float tNear = max(max(t1.x, t1.y), max(t1.z, 0.0));
+    float tFar = min(min(t2.x, t2.y), min(t2.z, tMax));
+
+    return tNear <= tFar;
+}
+
+// Any hit closer than tMax: shadow rays stop at the first blocker instead of searching for the closest one
+bool Occluded(Ray ray, float tMax) {
+    if (ENABLE_SPHERES) {
+        for (int j = 0; j < numSpheres; j++) {
+            if (RaySphereOccludes(ray, spheres[j], tMax)) return true;
+        }
+    }
+
+    if (ENABLE_MESHES) {
+        vec3 invDir = 1.0 / ray.dir;
+
+        for (int i = 0; i < numMeshes; i++) {
+            uint stack[BVH_STACK_SIZE];
+            uint stackTopIndex = 0;
+            stack[stackTopIndex++] = meshes[i].start;
+
+            while (stackTopIndex != 0) {
+                BVH_Node node = nodes[stack[--stackTopIndex]];
+
+                // Leaves are culled as well, a box test is cheaper than the triangles it holds
+                if (!RayBoundingBoxOverlaps(ray.ori, invDir, node.bbox.min, node.bbox.max, tMax)) continue;
+
+                if (node.left == 0 && node.right == 0) {
+                    for (uint t = node.start; t < node.start + node.count; t++) {
+                        if (RayTriangleOccludes(ray, triangles[t], tMax)) return true;
+                    }
+                } else {
+                    stack[stackTopIndex++] = node.left;
+                    stack[stackTopIndex++] = node.right;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+/////////// Light sampling ///////////
+struct LightSample {
+    vec3 dir;
+    float dst; // To the sampled point
+    vec3 radiance;
+    float pdf; // Solid angle density, light selection included. 0 when the light is not visible from the point
+};
+
+// Emitted power up to a constant factor, Scene builds the light list with the same formula
+float LightPower(Material mat, float area) {
+    vec3 emitted = mat.emissionColor * mat.emissionStrength;
+    return (emitted.r + emitted.g + emitted.b) / 3.0 * area;
+}
+
+float PowerHeuristic(float pdf, float otherPdf) {
+    return pdf * pdf / (pdf * pdf + otherPdf * otherPdf);
+}
+
+bool SamplesLights(Material mat) {
+    // Mixed specular directions have no density to weight against, those bounces only find lights by hitting them
+    return lightSampling != 0 && numLights > 0 && mat.smoothness == 0.0;
+}
+
+float SphereArea(Sphere sphere) {
+    return 4.0 * PI * sphere.rad * sphere.rad;
+}
+
+// Uniform density over the cone of directions subtended by the sphere, 0 from inside it
+float SphereConePdf(vec3 point, Sphere sphere) {
+    vec3 toCenter = sphere.pos - point;
+    float sinThetaMax2 = sphere.rad * sphere.rad / dot(toCenter, toCenter);
+    if (sinThetaMax2 >= 1.0) return 0.0;
+
+    // 1 - cosThetaMax without the cancellation of small, distant spheres
+    float oneMinusCos = sinThetaMax2 / (1.0 + sqrt(1.0 - sinThetaMax2));
+    return 1.0 / (2.0 * PI * oneMinusCos);
+}
+
+// Density light sampling would have had for a direction that hit an emitter from `origin`
+float LightPdf(vec3 origin, vec3 hitPoint, vec3 normal, Material mat, uint material, uint triangle) {
+    if (material < numSpheres) {
+        Sphere sphere = spheres[material];
+        return LightPower(mat, SphereArea(sphere)) / lightPower * SphereConePdf(origin, sphere);
+    }
+
+    Triangle t = triangles[triangle];
+    float area = 0.5 * length(cross(t.b - t.a, t.c - t.a));
+    vec3 toLight = hitPoint - origin;
+    float dst2 = dot(toLight, toLight);
+    float cosLight = -dot(normal, toLight) * inversesqrt(dst2);
+    return LightPower(mat, area) / lightPower * dst2 / (cosLight * area);
+}
+
+// MIS weight of emission found by a bounce, bsdfPdf is 0 when the previous hit did not sample the lights
+float EmissionWeight(float bsdfPdf, vec3 origin, vec3 hitPoint, vec3 normal, Material mat, uint material,
+                     uint triangle) {
+    if (bsdfPdf == 0.0 || LightPower(mat, 1.0) <= 0.0) return 1.0;
+    return PowerHeuristic(bsdfPdf, LightPdf(origin, hitPoint, normal, mat, material, triangle));
+}
+
+// Picks a light in proportion to its power, then a point on it seen from `point`
+LightSample SampleLight(vec3 point, inout SampleStream stream) {
+    float u = NextSample(stream);
+    vec2 uv = NextSample2D(stream);
+    float u1 = uv.x;
+    float u2 = uv.y;
+
+    uint lo = 0;
+    uint hi = numLights - 1;
+    while (lo < hi) {
+        uint mid = (lo + hi) / 2;
+        if (lights[mid].cdf <= u) lo = mid + 1;
+        else hi = mid;
+    }
+    Light light = lights[lo];
+    float selectPdf = light.cdf - (lo > 0 ? lights[lo - 1].cdf : 0.0);
+
+    Material mat = GetMaterial(light.material);
+
+    LightSample result;
+    result.radiance = mat.emissionColor * mat.emissionStrength;
+    result.pdf = 0.0;
+
+    if (light.material < numSpheres) {
+        Sphere sphere = spheres[light.primitive];
+        float conePdf = SphereConePdf(point, sphere);
+        if (conePdf == 0.0) return result;
+
+        vec3 axis = normalize(sphere.pos - point);
+        float cosTheta = 1.0 - u1 / (2.0 * PI * conePdf);
+        float sinTheta = sqrt(max(1.0 - cosTheta * cosTheta, 0.0));
+        float phi = 2.0 * PI * u2;
+
+        vec3 tangent, bitangent;
+        Basis(axis, tangent, bitangent);
+        result.dir = normalize(sinTheta * cos(phi) * tangent + sinTheta * sin(phi) * bitangent + cosTheta * axis);
+
+        // Grazing directions can miss the sphere by rounding
+        HitInfo hit = RaySphereIntersection(Ray(point, result.dir), sphere);
+        if (!hit.didCollide) return result;
+
+        result.dst = hit.dst;
+        result.pdf = selectPdf * conePdf;
+    } else {
+        Triangle t = triangles[light.primitive];
+        float su = sqrt(u1);
+        vec3 target = t.a * (1.0 - su) + t.b * (u2 * su) + t.c * (su - u2 * su);
+
+        vec3 normal = cross(t.b - t.a, t.c - t.a);
+        float area = 0.5 * length(normal);
+        vec3 toLight = target - point;
+        float dst2 = dot(toLight, toLight);
+        result.dst = sqrt(dst2);
+        result.dir = toLight / result.dst;
+
+        // Triangles only emit on their front face, the one RayTriangleIntersection() can hit
+        float cosLight = -dot(result.dir, normal) / (2.0 * area);
+        if (cosLight <= 0.0) return result;
+
+        result.pdf = selectPdf / area * dst2 / cosLight;
+    }
+
+    return result;
+}
+
+// Next-event estimation at a diffuse hit: one light sample and its shadow ray.
+// rayCount is incremented when the shadow ray is traced.
+vec3 DirectLight(vec3 point, vec3 normal, Material mat, inout SampleStream stream, inout uint rayCount) {
+    LightSample light = SampleLight(point, stream);
+    float cosine = dot(normal, light.dir);
+    if (light.pdf == 0.0 || cosine <= 0.0) return vec3(0.0);
+
+    rayCount++;
+    if (Occluded(Ray(point, light.dir), light.dst * (1.0 - SHADOW_EPSILON))) return vec3(0.0);
+
+    float bsdfPdf = cosine / PI;
+    return mat.color / PI * cosine * light.radiance * PowerHeuristic(light.pdf, bsdfPdf) / light.pdf;
+}
+
+vec3 AmbientLight(Ray ray) {
+    vec3 dir = normalize(ray.dir);
+
+    float t = 0.5 * (dir.y + 1.0);
+
+    vec3 horizonColor = vec3(1.0);
+    vec3 skyColor = vec3(0.5, 0.7, 1.0);
+
+    return mix(horizonColor, skyColor, t);
+}
+
+// One atomic per subgroup, the carry keeps the count exact past 2^32
+void CountRays(uint rayCount) {
+    uint subgroupRays = subgroupAdd(rayCount);
+    if (subgroupElect()) {
+        uint previous = atomicAdd(rayCountLow, subgroupRays);
+        if (previous + subgroupRays < previous) atomicAdd(rayCountHigh, 1u);
+    }
+}
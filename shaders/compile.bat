@@ -2,6 +2,32 @@ glslc.exe main.vert -o main.vert.spv
 
 glslc.exe main.frag -o main.frag.spv
 
-glslc.exe main.comp -o main.comp.spv
+glslc.exe --target-env=vulkan1.3 main.comp -o main.comp.spv
+
+glslc.exe --target-env=vulkan1.3 wavefront_generate.comp -o wavefront_generate.comp.spv
+
+glslc.exe --target-env=vulkan1.3 wavefront_args.comp -o wavefront_args.comp.spv
+
+glslc.exe --target-env=vulkan1.3 wavefront_extend.comp -o wavefront_extend.comp.spv
+
+glslc.exe --target-env=vulkan1.3 wavefront_shade.comp -o wavefront_shade.comp.spv
+
+glslc.exe --target-env=vulkan1.3 wavefront_miss.comp -o wavefront_miss.comp.spv
+
+glslc.exe --target-env=vulkan1.3 persistent.comp -o persistent.comp.spv
+
+glslc.exe --target-env=vulkan1.3 sort_keys.comp -o sort_keys.comp.spv
+
+glslc.exe --target-env=vulkan1.3 sort_histogram.comp -o sort_histogram.comp.spv
+
+glslc.exe --target-env=vulkan1.3 sort_scan_blocks.comp -o sort_scan_blocks.comp.spv
+
+glslc.exe --target-env=vulkan1.3 sort_scan.comp -o sort_scan.comp.spv
+
+glslc.exe --target-env=vulkan1.3 sort_scatter.comp -o sort_scatter.comp.spv
+
+glslc.exe --target-env=vulkan1.3 adaptive_mask.comp -o adaptive_mask.comp.spv
+
+glslc.exe --target-env=vulkan1.3 resolve.comp -o resolve.comp.spv
 
 pause
\ No newline at end of file
@@ -1,10 +1,16 @@
 #version 450
 
-layout (set = 0, binding = 0) uniform sampler2D resultImage;
+layout (set = 0, binding = 0) uniform sampler2D displayImage;
+
+// BlitData in GraphicsPipeline.h: the traced region of the image, smaller than it at reduced render scales
+layout (push_constant) uniform BlitData {
+    vec2 uvScale;
+    vec2 uvMax;
+};
 
 layout (location = 0) in vec2 inUV;
 layout (location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(resultImage, inUV);
+    outColor = texture(displayImage, min(inUV * uvScale, uvMax));
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+// Whole-path tracing of a single pixel, after common.glsl. Shared by the per-pixel and the persistent kernels.
+
+vec3 Trace(Ray ray, inout SampleStream stream, inout uint rayCount) {
+    vec3 incomingLight = vec3(0.0);
+    vec3 rayColor = vec3(1.0);
+    float bsdfPdf = 0.0; // Of the last bounce, when its hit also sampled the lights
+
+    for (uint i = 0; i < MaxBounces(); i++) {
+        HitInfo hitInfo = ClosestHit(ray);
+        rayCount++;
+
+        if (hitInfo.didCollide) {
+            Material mat = hitInfo.mat;
+            StartBounce(stream, i);
+            float weight = EmissionWeight(bsdfPdf, ray.ori, hitInfo.hitPoint, hitInfo.normal, mat,
+                                          hitInfo.material, hitInfo.triangle);
+            incomingLight += mat.emissionColor * rayColor * mat.emissionStrength * weight;
+
+            ray.ori = hitInfo.hitPoint + hitInfo.normal * EPSILON;
+            bool sampleLights = SamplesLights(mat);
+            if (sampleLights) incomingLight += DirectLight(ray.ori, hitInfo.normal, mat, stream, rayCount) * rayColor;
+
+            vec3 diffuseDir = CosineSampleHemisphere(hitInfo.normal, NextSample2D(stream));
+            vec3 specularDir = reflect(ray.dir, hitInfo.normal);
+            ray.dir = mix(diffuseDir, specularDir, mat.smoothness);
+            bsdfPdf = sampleLights ? dot(diffuseDir, hitInfo.normal) / PI : 0.0;
+
+            rayColor *= mat.color;
+
+            if (!SurvivesRoulette(i + 1, rayColor, stream)) break;
+        } else {
+            incomingLight += AmbientLight(ray) * rayColor;
+            break;
+        }
+    }
+
+    return incomingLight;
+}
+
+// Accumulates the samples of the pixel's tile in registers, returns the number of rays they traced
+uint RenderPixel(ivec2 coord) {
+    uint samples = TileSamples(coord);
+    if (samples == 0) return 0;
+
+    uint pixel = coord.y * imageWidth + coord.x;
+    uint first = PixelSamples(pixel);
+
+    uint rayCount = 0;
+    vec3 colorSum = vec3(0.0);
+    float lumSquaredSum = 0.0;
+    for (uint s = 0; s < samples; s++) {
+        SampleStream stream = StartSample(pixel, first + s);
+        Ray ray = GenerateRay(coord, stream);
+        vec3 color = Trace(ray, stream, rayCount);
+
+        float luminance = Luminance(color);
+        colorSum += color;
+        lumSquaredSum += luminance * luminance;
+    }
+
+    StorePixel(coord, colorSum, lumSquaredSum, samples);
+    return rayCount;
+}
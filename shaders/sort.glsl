@@ -0,0 +1,47 @@
+// Radix sort of the wavefront ray queue, after wavefront.glsl. Before the extend stage of a secondary bounce:
+//   keys -> (histogram -> scan blocks -> scan -> scatter) x SORT_PASSES
+// A key is the direction octant above the Morton code of the origin cell in the scene bounds, so that rays
+// leaving the same region in the same general direction are traced by neighbouring lanes.
+
+#define SORT_GROUP_SIZE 256 // One thread per digit in the histogram
+#define SORT_RADIX 256
+#define SORT_PASSES 3       // SORT_PASSES in ComputePipeline.h, 8 bits each
+#define INVALID_KEY 0xFFFFFFFFu
+
+// Two halves of (key, ray index) pairs, each pass reads one and writes the other
+layout (set = 0, binding = 14, std430) buffer SortPairs {
+    uvec2 pairs[];
+};
+
+// Count of every digit per block, digit-major, then scanned in place into scatter offsets. The scan runs on
+// blocks of SORT_RADIX counts, their sums follow the histograms of the largest queue.
+layout (set = 0, binding = 15, std430) buffer SortHistograms {
+    uint histograms[];
+};
+
+uint PairIndex(uint side, uint i) {
+    return side * PathCount() + i;
+}
+
+uint SortBlockCount() {
+    return (rayCount[bounce] + SORT_GROUP_SIZE - 1) / SORT_GROUP_SIZE;
+}
+
+// The histograms of a queue hold SortBlockCount() scan blocks
+uint ScanSumIndex(uint scanBlock) {
+    return SORT_RADIX * ((PathCount() + SORT_GROUP_SIZE - 1) / SORT_GROUP_SIZE) + scanBlock;
+}
+
+// Offset of a digit's pairs, combining the scans of both levels
+uint ScatterOffset(uint index) {
+    return histograms[index] + histograms[ScanSumIndex(index / SORT_RADIX)];
+}
+
+uint Digit(uint key) {
+    return (key >> (sortPass * 8u)) & (SORT_RADIX - 1u);
+}
+
+// Index in the ray queues of the i-th ray in sorted order
+uint SortedRay(uint i) {
+    return pairs[PairIndex(SORT_PASSES & 1u, i)].y;
+}
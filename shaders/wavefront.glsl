@@ -0,0 +1,72 @@
+// Queues of the wavefront integrator, after common.glsl. Each bounce runs:
+//   args -> [sort] -> extend -> args -> miss + shade
+// extend finds the closest hit of every queued ray, miss and shade consume its two output queues,
+// and shade queues the rays of the next bounce. Counters are per bounce and cleared once per frame.
+
+#define WAVEFRONT_GROUP_SIZE 64
+
+struct PathState {
+    vec3 throughput;
+    uint seed;
+    vec3 radiance;
+    float bsdfPdf; // Of the last bounce, when its hit also sampled the lights
+};
+
+struct QueuedRay {
+    vec3 ori;
+    uint path; // Pixel index
+    vec3 dir;
+};
+
+struct QueuedHit {
+    vec3 normal;
+    float dst;
+    uint ray; // Index in the ray queues
+    uint material;
+    uint triangle;
+};
+
+struct DispatchArgs {
+    uint x, y, z;
+};
+
+layout (set = 0, binding = 8, std430) buffer PathStates {
+    PathState paths[];
+};
+
+// Two queues of one ray per pixel: a bounce reads one and fills the other
+layout (set = 0, binding = 9, std430) buffer RayQueues {
+    QueuedRay rays[];
+};
+
+layout (set = 0, binding = 10, std430) buffer HitQueue {
+    QueuedHit hits[];
+};
+
+layout (set = 0, binding = 11, std430) buffer MissQueue {
+    uint misses[]; // Indices in the ray queues
+};
+
+layout (set = 0, binding = 12, std430) buffer WavefrontCounters {
+    uint rayCount[MAX_BOUNCES];
+    uint hitCount[MAX_BOUNCES];
+    uint missCount[MAX_BOUNCES];
+    DispatchArgs extendArgs[MAX_BOUNCES];
+    DispatchArgs shadeArgs[MAX_BOUNCES];
+    DispatchArgs missArgs[MAX_BOUNCES];
+    DispatchArgs sortArgs[MAX_BOUNCES];
+};
+
+uint PathCount() {
+    return imageWidth * imageHeight;
+}
+
+uint RayIndex(uint rayBounce, uint i) {
+    return (rayBounce & 1u) * PathCount() + i;
+}
+
+// Same accumulation as the megakernel, once per path when it terminates
+void StorePath(uint path, vec3 radiance) {
+    float luminance = Luminance(radiance);
+    StorePixel(ivec2(path % imageWidth, path / imageWidth), radiance, luminance * luminance, 1);
+}
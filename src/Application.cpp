@@ -4,9 +4,11 @@
 #include <chrono>
 
 #include "Core/Log.h"
+#include "Core/Trace.h"
 #include "UI/ApplicationUI.h"
 
-Application::Application(const std::string& title, uint32_t width, uint32_t height) {
+Application::Application(const std::string& title, uint32_t width, uint32_t height) :
+    startTime(std::chrono::steady_clock::now()) {
     try {
         window = std::make_shared<Window>(width, height, title);
         vulkanContext = std::make_shared<VulkanContext>(window);
@@ -26,29 +28,63 @@ void Application::Run() {
     float dt = 0.0f;
 
     while (!window->ShouldClose()) {
+        // Nothing left to accumulate: sleep until the next input instead of presenting the same image again.
+        // The wait is not part of any frame, the camera must not move by its length.
+        if (IsIdle()) {
+            window->WaitEvents();
+            lastTick = clock::now();
+            activeFrames = ACTIVE_FRAMES_AFTER_WAIT;
+        } else {
+            window->PollEvents();
+            if (activeFrames > 0) activeFrames--;
+        }
+
         auto now = clock::now();
         std::chrono::duration<float> elapsed = now - lastTick;
         dt = elapsed.count();
         lastTick = now;
 
+        TRACE_SCOPE("Application::Frame");
         Update(dt);
         Render();
+        LogStartupTime();
     }
 }
 
-void Application::Update(const float dt) const {
-    window->PollEvents();
+void Application::Update(const float dt) {
+    TRACE_SCOPE("Application::Update");
 
+    timeSinceKeyframe += dt;
     if (cameraController->Update(raytracer->GetCamera(), dt)) {
         raytracer->SetDirty(DirtyFlags::Camera);
+
+        if (recordingPath && timeSinceKeyframe >= KEYFRAME_INTERVAL) {
+            recordedPath.AddKeyframe(raytracer->GetCamera());
+            timeSinceKeyframe = 0.0f;
+        }
     }
 
     raytracer->Update(window->GetWidth(), window->GetHeight());
     renderer->Update(*raytracer);
 }
 
+bool Application::IsIdle() const {
+    // Dirty flags set by the UI or the controller restart the accumulation in the next update
+    return activeFrames == 0 && !raytracer->IsAnyDirty() && renderer->IsIdle();
+}
+
 void Application::Render() {
+    TRACE_SCOPE("Application::Render");
     renderer->Begin();
     UI::DrawApplication(*this);
     renderer->Draw();
 }
+
+void Application::LogStartupTime() {
+    if (startupLogged || renderer->GetFrameStats().presentedFrames == 0) return;
+
+    // Covers device creation and every pipeline compilation, compare cold and warm pipeline caches
+    const auto elapsed = std::chrono::steady_clock::now() - startTime;
+    LOGI("First frame presented after {:.1f} ms", std::chrono::duration<float, std::milli>(elapsed).count());
+    startupLogged = true;
+}
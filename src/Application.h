@@ -1,11 +1,13 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 
 #include "Window/Window.h"
 #include "Vulkan/VulkanContext.h"
 #include "Renderer/Renderer.h"
+#include "Raytracer/CameraPath.h"
 #include "Raytracer/Raytracer.h"
 #include "Controller/CameraController.h"
 #include "UI/ApplicationUI.h"
@@ -17,8 +19,10 @@ public:
     ~Application() = default;
 
 private:
-    void Update(float dt) const;
+    void Update(float dt);
     void Render();
+    bool IsIdle() const;
+    void LogStartupTime();
 
     friend void UI::DrawApplication(Application& app);
 
@@ -29,4 +33,17 @@ private:
 
     std::unique_ptr<Raytracer> raytracer;
     std::unique_ptr<CameraController> cameraController;
+
+    // Camera path recorded from the controller, replayed by the benchmark mode
+    static constexpr float KEYFRAME_INTERVAL = 0.25f;
+    CameraPath recordedPath;
+    bool recordingPath = false;
+    float timeSinceKeyframe = 0.0f;
+
+    // Frames drawn after an idle wait, for the UI to settle and held keys to be polled with a real dt
+    static constexpr uint32_t ACTIVE_FRAMES_AFTER_WAIT = 3;
+    uint32_t activeFrames = 0;
+
+    std::chrono::steady_clock::time_point startTime;
+    bool startupLogged = false;
 };
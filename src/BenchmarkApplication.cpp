@@ -0,0 +1,244 @@
+#include "BenchmarkApplication.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <numeric>
+
+#include "Core/ImageCompare.h"
+#include "Core/Log.h"
+#include "Serialize/Serialize.h"
+
+namespace {
+    // Nearest-rank percentile of sorted values
+    float Percentile(const std::vector<float>& sorted, const float p) {
+        if (sorted.empty()) return 0.0f;
+        const auto rank = static_cast<size_t>(std::ceil(p / 100.0f * static_cast<float>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+}
+
+BenchmarkApplication::BenchmarkApplication(const CommandLine::Options& options) : options(options) {
+    try {
+        vulkanContext = std::make_shared<VulkanContext>(nullptr);
+        renderer = std::make_unique<HeadlessRenderer>(vulkanContext);
+        raytracer = std::make_unique<Raytracer>(options.width, options.height);
+    } catch (const std::exception& e) {
+        LOGE("Failed to initialize benchmark: {}", e.what());
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+int BenchmarkApplication::Run() const {
+    const auto loadStart = std::chrono::steady_clock::now();
+    if (!raytracer->LoadFromFile(options.scene)) return EXIT_FAILURE;
+    const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    CommandLine::ApplyOverrides(options, raytracer->GetSettings());
+
+    // Without a path the scene camera is the only pose
+    CameraPath path;
+    if (!options.cameraPath.empty()) {
+        if (!path.LoadFromFile(options.cameraPath)) return EXIT_FAILURE;
+    }
+    if (path.Empty()) path.AddKeyframe(raytracer->GetCamera());
+
+    auto [frameMs, poseSeconds, rays, pixelSamples, uploadSeconds, renderSeconds] = RenderPath(path);
+
+    std::ranges::sort(frameMs);
+    const double meanFrameMs = frameMs.empty()
+                                   ? 0.0
+                                   : std::accumulate(frameMs.begin(), frameMs.end(), 0.0) / frameMs.size();
+
+    const double samplesPerSecond = pixelSamples / renderSeconds;
+    const double raysPerSecond = rays / renderSeconds;
+    const double pathLength = static_cast<double>(rays) / pixelSamples;
+
+    Json report = {
+        {"device", vulkanContext->physicalDevice.getProperties().deviceName.data()},
+        {"scene", options.scene.generic_string()},
+        {"cameraPath", options.cameraPath.generic_string()},
+        {"width", options.width},
+        {"height", options.height},
+        {"samplesPerPose", options.samples},
+        {"settings", raytracer->GetSettings()},
+        {"persistentGroups", renderer->GetPersistentGroupCount()},
+        {"poses", path.Size()},
+        {"sceneLoadMs", loadMs},
+        {"bvhBuildMs", raytracer->GetScene().GetBVHBuildMs()},
+        {"triangles", raytracer->GetScene().GetTriangles().size()},
+        {"uploadBytes", renderer->GetUploadedBytes()},
+        {"uploadMs", uploadSeconds * 1000.0},
+        {"renderSeconds", renderSeconds},
+        {"poseSeconds", poseSeconds},
+        {
+            "frameMs", {
+                {"count", frameMs.size()},
+                {"mean", meanFrameMs},
+                {"min", frameMs.empty() ? 0.0f : frameMs.front()},
+                {"p50", Percentile(frameMs, 50.0f)},
+                {"p90", Percentile(frameMs, 90.0f)},
+                {"p99", Percentile(frameMs, 99.0f)},
+                {"max", frameMs.empty() ? 0.0f : frameMs.back()},
+            }
+        },
+        {"gpuScopes", renderer->GetGpuProfiler().ToJson()},
+        {"uploadScopes", renderer->GetUploadProfiler().ToJson()},
+        {"rays", rays},
+        {"averagePathLength", pathLength},
+        {"samplesPerSecond", samplesPerSecond},
+        {"raysPerSecond", raysPerSecond},
+    };
+
+    LOGI("Benchmark: {} poses x {} spp in {:.3f} s, p50 {:.2f} ms/frame, {:.2f} Msamples/s, {:.2f} Mrays/s, "
+         "{:.2f} rays/path", path.Size(), options.samples, renderSeconds, Percentile(frameMs, 50.0f),
+         samplesPerSecond * 1e-6, raysPerSecond * 1e-6, pathLength);
+
+    std::ofstream write(options.report);
+    if (!write.is_open()) {
+        LOGE("Failed to open file: {}", options.report.string());
+        return EXIT_FAILURE;
+    }
+    if (options.sweep) report["sweep"] = Sweep(path);
+    if (options.convergence) report["convergence"] = Convergence(path.GetKeyframes().front());
+
+    write << std::setw(4) << report << std::endl;
+    LOGI("Saved benchmark report: {}", options.report.string());
+
+    return EXIT_SUCCESS;
+}
+
+BenchmarkApplication::PathResult BenchmarkApplication::RenderPath(const CameraPath& path) const {
+    PathResult result;
+
+    for (const Camera& pose : path.GetKeyframes()) {
+        raytracer->GetCamera() = pose;
+        raytracer->SetDirty(DirtyFlags::Camera);
+
+        const OfflineRenderResult render = renderer->Render(*raytracer, options.samples);
+
+        result.frameMs.insert(result.frameMs.end(), render.frameMs.begin(), render.frameMs.end());
+        result.poseSeconds.push_back(render.renderSeconds);
+        result.rays += render.rays;
+        result.pixelSamples += render.pixelSamples * render.width * render.height;
+        result.uploadSeconds += render.uploadSeconds;
+        result.renderSeconds += render.renderSeconds;
+    }
+
+    return result;
+}
+
+Json BenchmarkApplication::Sweep(const CameraPath& path) const {
+    constexpr std::array BOUNCES = {1u, 2u, 4u, 8u};
+
+    const RenderSettings settings = raytracer->GetSettings();
+
+    Json sweep = Json::array();
+    const auto run = [&](const Integrator integrator, const uint32_t bounces, const bool sortRays,
+                         const bool roulette) {
+        raytracer->GetSettings().integrator = integrator;
+        raytracer->GetSettings().maxBounces = bounces;
+        raytracer->GetSettings().sortRays = sortRays;
+        raytracer->GetSettings().russianRoulette = roulette;
+        raytracer->SetDirty(DirtyFlags::Settings);
+
+        const PathResult result = RenderPath(path);
+        const double samplesPerSecond = result.pixelSamples / result.renderSeconds;
+        const double raysPerSecond = result.rays / result.renderSeconds;
+        const double pathLength = static_cast<double>(result.rays) / result.pixelSamples;
+
+        LOGI("Sweep: {:<10}{:<10} {} bounces, {:.3f} s, {:.2f} Msamples/s, {:.2f} Mrays/s, {:.2f} rays/path",
+             ToString(integrator), sortRays ? " sorted" : roulette ? " roulette" : "", bounces,
+             result.renderSeconds, samplesPerSecond * 1e-6, raysPerSecond * 1e-6, pathLength);
+
+        sweep.push_back({
+            {"integrator", ToString(integrator)},
+            {"sortRays", sortRays},
+            {"russianRoulette", roulette},
+            {"lightSampling", raytracer->GetSettings().lightSampling},
+            {"maxBounces", bounces},
+            {"renderSeconds", result.renderSeconds},
+            {"rays", result.rays},
+            {"averagePathLength", pathLength},
+            {"samplesPerSecond", samplesPerSecond},
+            {"raysPerSecond", raysPerSecond},
+        });
+    };
+
+    for (const uint32_t bounces : BOUNCES) {
+        for (const Integrator integrator : INTEGRATORS) {
+            run(integrator, bounces, false, false);
+
+            // Sorting only applies to the wavefront queues, its cost grows with the bounces it has to pay off
+            if (integrator == Integrator::Wavefront) run(integrator, bounces, true, false);
+        }
+
+        // Shorter paths at the minimum depth of the scene settings, against the megakernel run above
+        run(Integrator::Megakernel, bounces, false, true);
+    }
+
+    raytracer->GetSettings() = settings;
+    raytracer->SetDirty(DirtyFlags::Settings);
+    return sweep;
+}
+
+Json BenchmarkApplication::Convergence(const Camera& pose) const {
+    const RenderSettings settings = raytracer->GetSettings();
+    raytracer->GetCamera() = pose;
+    raytracer->SetDirty(DirtyFlags::Camera);
+
+    // Every option converges to the same image, the reference uses the one with the least noise.
+    // White noise shares its first samples with the white noise runs, which only favors them.
+    raytracer->GetSettings().lightSampling = true;
+    raytracer->GetSettings().sampleSequence = SampleSequence::WhiteNoise;
+    raytracer->SetDirty(DirtyFlags::Settings);
+    const OfflineRenderResult reference = renderer->Render(*raytracer, options.convergence);
+    LOGI("Convergence: {:.1f} spp reference in {:.3f} s", reference.pixelSamples, reference.renderSeconds);
+
+    Json runs = Json::array();
+    double baselineSeconds = 0.0;
+    const auto run = [&](const bool lightSampling, const SampleSequence sequence) {
+        raytracer->GetSettings().lightSampling = lightSampling;
+        raytracer->GetSettings().sampleSequence = sequence;
+        raytracer->SetDirty(DirtyFlags::Settings);
+
+        const OfflineRenderResult image = renderer->Render(*raytracer, options.samples);
+        const double rmse = ImageCompare::Compare(image.pixels, reference.pixels).rmse;
+
+        // Variance falls with the time spent, the error scales with its square root
+        if (baselineSeconds == 0.0) baselineSeconds = image.renderSeconds;
+        const double equalTimeRmse = rmse * std::sqrt(image.renderSeconds / baselineSeconds);
+
+        // With adaptive sampling, pixels that stopped early cost fewer samples than were requested
+        LOGI("Convergence: light sampling {:<3} {:<11} {:.1f} spp in {:.3f} s, RMSE {:.6f}, {:.6f} at equal time",
+             lightSampling ? "on" : "off", ToString(sequence), image.pixelSamples, image.renderSeconds, rmse,
+             equalTimeRmse);
+
+        runs.push_back({
+            {"lightSampling", lightSampling},
+            {"sampleSequence", ToString(sequence)},
+            {"pixelSamples", image.pixelSamples},
+            {"renderSeconds", image.renderSeconds},
+            {"rays", image.rays},
+            {"rmse", rmse},
+            {"equalTimeRmse", equalTimeRmse},
+        });
+    };
+
+    // The first run is the baseline the others are scaled to
+    for (const bool lightSampling : {false, true}) {
+        for (const SampleSequence sequence : SAMPLE_SEQUENCES) run(lightSampling, sequence);
+    }
+
+    raytracer->GetSettings() = settings;
+    raytracer->SetDirty(DirtyFlags::Settings);
+
+    return {
+        {"referenceSamples", options.convergence},
+        {"referencePixelSamples", reference.pixelSamples},
+        {"referenceSeconds", reference.renderSeconds},
+        {"samples", options.samples},
+        {"runs", runs},
+    };
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Core/CommandLine.h"
+#include "Serialize/Base.h"
+#include "Vulkan/VulkanContext.h"
+#include "Renderer/HeadlessRenderer.h"
+#include "Raytracer/CameraPath.h"
+#include "Raytracer/Raytracer.h"
+
+// Renders a fixed number of samples for every pose of a camera path and writes a JSON report,
+// meant to be compared between releases
+class BenchmarkApplication {
+public:
+    explicit BenchmarkApplication(const CommandLine::Options& options);
+    ~BenchmarkApplication() = default;
+
+    // Returns the process exit code
+    int Run() const;
+
+private:
+    struct PathResult {
+        std::vector<float> frameMs;
+        std::vector<double> poseSeconds;
+        uint64_t rays = 0;
+        double pixelSamples = 0.0; // Over every pixel and pose, as counted by the renderer
+        double uploadSeconds = 0.0;
+        double renderSeconds = 0.0;
+    };
+
+    PathResult RenderPath(const CameraPath& path) const;
+
+    // Every integrator at several bounce counts, logged and returned for the report
+    Json Sweep(const CameraPath& path) const;
+
+    // RMSE of each sampling option against a high sample count reference of one pose, also scaled to equal time
+    Json Convergence(const Camera& pose) const;
+
+private:
+    CommandLine::Options options;
+
+    std::shared_ptr<VulkanContext> vulkanContext;
+    std::unique_ptr<HeadlessRenderer> renderer;
+    std::unique_ptr<Raytracer> raytracer;
+};
@@ -0,0 +1,228 @@
+#include "CommandLine.h"
+
+#include <charconv>
+#include <format>
+#include <string_view>
+
+namespace CommandLine {
+    static std::expected<uint32_t, std::string> ParseCount(const std::string_view name, const std::string_view value) {
+        uint32_t result = 0;
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (error != std::errc{} || end != value.data() + value.size() || result == 0) {
+            return std::unexpected(std::format("{} expects a positive integer, got '{}'", name, value));
+        }
+        return result;
+    }
+
+    static std::expected<float, std::string> ParseFraction(const std::string_view name, const std::string_view value) {
+        float result = 0.0f;
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (error != std::errc{} || end != value.data() + value.size() || !(result > 0.0f && result <= 1.0f)) {
+            return std::unexpected(std::format("{} expects a number in (0, 1], got '{}'", name, value));
+        }
+        return result;
+    }
+
+    std::expected<Options, std::string> Parse(const int argc, char** argv) {
+        Options options;
+
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+
+            if (arg == "--help" || arg == "-h") {
+                options.help = true;
+                continue;
+            }
+
+            if (arg == "--headless") {
+                options.headless = true;
+                continue;
+            }
+
+            if (arg == "--benchmark") {
+                options.benchmark = true;
+                continue;
+            }
+
+            if (arg == "--traversal-benchmark") {
+                options.traversalBenchmark = true;
+                continue;
+            }
+
+            if (arg == "--sweep") {
+                options.sweep = true;
+                continue;
+            }
+
+            if (arg == "--sort-rays") {
+                options.sortRays = true;
+                continue;
+            }
+
+            if (arg == "--no-light-sampling") {
+                options.noLightSampling = true;
+                continue;
+            }
+
+            if (arg == "--cpu") {
+                options.cpu = true;
+                continue;
+            }
+
+            if (arg == "--compare") {
+                options.compare = true;
+                continue;
+            }
+
+            // Every other option takes a value
+            if (i + 1 >= argc) return std::unexpected(std::format("Missing value for {}", arg));
+            const std::string_view value = argv[++i];
+
+            if (arg == "--scene") {
+                options.scene = value;
+            } else if (arg == "--output" || arg == "-o") {
+                options.output = value;
+            } else if (arg == "--camera-path") {
+                options.cameraPath = value;
+            } else if (arg == "--report") {
+                options.report = value;
+            } else if (arg == "--trace") {
+                options.trace = value;
+            } else if (arg == "--integrator") {
+                options.integrator = ParseIntegrator(value);
+                if (!options.integrator) return std::unexpected(std::format("Unknown integrator '{}'", value));
+            } else if (arg == "--sequence") {
+                options.sampleSequence = ParseSampleSequence(value);
+                if (!options.sampleSequence) return std::unexpected(std::format("Unknown sequence '{}'", value));
+            } else if (arg == "--adaptive") {
+                const auto threshold = ParseFraction(arg, value);
+                if (!threshold) return std::unexpected(threshold.error());
+                options.adaptiveThreshold = *threshold;
+            } else if (arg == "--bounces") {
+                const auto bounces = ParseCount(arg, value);
+                if (!bounces) return std::unexpected(bounces.error());
+                if (*bounces > MAX_BOUNCES) {
+                    return std::unexpected(std::format("--bounces is at most {}, got {}", MAX_BOUNCES, *bounces));
+                }
+                options.bounces = *bounces;
+            } else if (arg == "--roulette") {
+                const auto depth = ParseCount(arg, value);
+                if (!depth) return std::unexpected(depth.error());
+                if (*depth > MAX_BOUNCES) {
+                    return std::unexpected(std::format("--roulette is at most {}, got {}", MAX_BOUNCES, *depth));
+                }
+                options.rouletteDepth = *depth;
+            } else if (arg == "--convergence") {
+                const auto samples = ParseCount(arg, value);
+                if (!samples) return std::unexpected(samples.error());
+                options.convergence = *samples;
+            } else if (arg == "--spp-per-dispatch") {
+                const auto samples = ParseCount(arg, value);
+                if (!samples) return std::unexpected(samples.error());
+                if (*samples > MAX_SAMPLES_PER_DISPATCH) {
+                    return std::unexpected(std::format("--spp-per-dispatch is at most {}, got {}",
+                                                       MAX_SAMPLES_PER_DISPATCH, *samples));
+                }
+                options.samplesPerDispatch = *samples;
+            } else if (arg == "--samples") {
+                const auto samples = ParseCount(arg, value);
+                if (!samples) return std::unexpected(samples.error());
+                options.samples = *samples;
+            } else if (arg == "--threads") {
+                const auto threads = ParseCount(arg, value);
+                if (!threads) return std::unexpected(threads.error());
+                options.threads = *threads;
+            } else if (arg == "--width") {
+                const auto width = ParseCount(arg, value);
+                if (!width) return std::unexpected(width.error());
+                options.width = *width;
+            } else if (arg == "--height") {
+                const auto height = ParseCount(arg, value);
+                if (!height) return std::unexpected(height.error());
+                options.height = *height;
+            } else {
+                return std::unexpected(std::format("Unknown option {}", arg));
+            }
+        }
+
+        if (options.headless && options.benchmark) {
+            return std::unexpected(std::string("--headless and --benchmark are exclusive"));
+        }
+
+        if (options.traversalBenchmark && (options.headless || options.benchmark)) {
+            return std::unexpected(std::format("--traversal-benchmark and {} are exclusive",
+                                               options.headless ? "--headless" : "--benchmark"));
+        }
+
+        if (options.sweep && !options.benchmark) {
+            return std::unexpected(std::string("--sweep requires --benchmark"));
+        }
+
+        if (options.convergence && !options.benchmark) {
+            return std::unexpected(std::string("--convergence requires --benchmark"));
+        }
+
+        if ((options.cpu || options.compare) && !options.headless) {
+            return std::unexpected(std::format("{} requires --headless", options.cpu ? "--cpu" : "--compare"));
+        }
+
+        if (options.cpu && options.compare) {
+            return std::unexpected(std::string("--cpu and --compare are exclusive"));
+        }
+
+        if ((options.headless || options.benchmark) && options.scene.empty()) {
+            return std::unexpected(std::format("{} requires --scene", options.headless ? "--headless" : "--benchmark"));
+        }
+
+        return options;
+    }
+
+    void ApplyOverrides(const Options& options, RenderSettings& settings) {
+        if (options.integrator) settings.integrator = *options.integrator;
+        if (options.bounces) settings.maxBounces = *options.bounces;
+        if (options.sortRays) settings.sortRays = true;
+        if (options.rouletteDepth) {
+            settings.russianRoulette = true;
+            settings.rouletteMinDepth = *options.rouletteDepth;
+        }
+        if (options.noLightSampling) settings.lightSampling = false;
+        if (options.sampleSequence) settings.sampleSequence = *options.sampleSequence;
+        if (options.adaptiveThreshold) {
+            settings.adaptiveSampling = true;
+            settings.adaptiveThreshold = *options.adaptiveThreshold;
+        }
+        if (options.samplesPerDispatch) settings.samplesPerDispatch = *options.samplesPerDispatch;
+    }
+
+    std::string Usage(const char* program) {
+        return std::format(
+            "Usage: {} [options]\n"
+            "  --width <n>           Image width (default 800)\n"
+            "  --height <n>          Image height (default 600)\n"
+            "  --headless            Render offline without a window, then exit\n"
+            "  --benchmark           Replay a camera path offline and write a report\n"
+            "  --traversal-benchmark Compare the CPU traversal kernels of each ISA level\n"
+            "  --scene <file>        Scene JSON saved from the UI (camera included)\n"
+            "  --samples <n>         Samples per pixel, per pose when benchmarking (default 64)\n"
+            "  -o, --output <file>   Image to write: .exr, .pfm or .png (default render.exr)\n"
+            "  --cpu                 Render on the CPU, headless only\n"
+            "  --compare             Render on the GPU and the CPU, then report the difference, and the\n"
+            "                        mean brightness against bounces only when light sampling is on\n"
+            "  --threads <n>         CPU renderer threads (default: all)\n"
+            "  --camera-path <file>  Keyframes to replay, the scene camera otherwise\n"
+            "  --report <file>       Benchmark report (default benchmark.json)\n"
+            "  --sweep               Benchmark every integrator and option at 1, 2, 4 and 8 bounces\n"
+            "  --convergence <n>     Benchmark the RMSE of each sampling option against an n spp reference\n"
+            "  --integrator <name>   megakernel, wavefront or persistent, overrides the scene settings\n"
+            "  --bounces <n>         Maximum bounces per path, overrides the scene settings\n"
+            "  --sort-rays           Sort the wavefront ray queues between bounces\n"
+            "  --roulette <n>        Russian roulette after n bounces, overrides the scene settings\n"
+            "  --no-light-sampling   Only find lights by bouncing into them, overrides the scene settings\n"
+            "  --sequence <name>     white-noise or sobol random numbers, overrides the scene settings\n"
+            "  --adaptive <error>    Adaptive sampling down to this relative error, overrides the scene settings\n"
+            "  --spp-per-dispatch <n> Samples traced per dispatch, overrides the scene settings\n"
+            "  --trace <file>        Record CPU zones, written as a Chrome trace on exit\n"
+            "  -h, --help            Show this message\n",
+            program);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "Raytracer/RenderSettings.h"
+
+namespace CommandLine {
+    struct Options {
+        uint32_t width = 800;
+        uint32_t height = 600;
+
+        // Offline rendering, without window or swapchain
+        bool headless = false;
+        std::filesystem::path scene;
+        std::filesystem::path output = "render.exr";
+        uint32_t samples = 64; // Per pose in benchmark mode
+
+        // Headless only: render on the CPU, or on both to compare the GPU image against the CPU reference
+        bool cpu = false;
+        bool compare = false;
+        uint32_t threads = 0; // 0 uses every hardware thread
+
+        // Benchmark, headless as well: replays a camera path and writes a JSON report
+        bool benchmark = false;
+        std::filesystem::path cameraPath;
+        std::filesystem::path report = "benchmark.json";
+        bool sweep = false; // Replays the path with every integrator at several bounce counts
+        uint32_t convergence = 0; // Samples of the reference that sampling options are measured against, 0 skips them
+
+        // Offline modes: override the render settings saved with the scene
+        std::optional<Integrator> integrator;
+        std::optional<uint32_t> bounces;
+        bool sortRays = false;
+        std::optional<uint32_t> rouletteDepth; // Enables Russian roulette from this depth
+        bool noLightSampling = false;
+        std::optional<SampleSequence> sampleSequence;
+        std::optional<float> adaptiveThreshold; // Enables adaptive sampling with this relative error
+        std::optional<uint32_t> samplesPerDispatch;
+
+        // Single-threaded rays/s of the CPU traversal kernels, per ISA level, on --scene or the bundled meshes
+        bool traversalBenchmark = false;
+
+        // Chrome trace of the CPU zones, written on exit
+        std::filesystem::path trace;
+
+        bool help = false;
+    };
+
+    std::expected<Options, std::string> Parse(int argc, char** argv);
+    void ApplyOverrides(const Options& options, RenderSettings& settings);
+    std::string Usage(const char* program);
+}
@@ -1,5 +1,6 @@
 #include "File.h"
 
+#include <cstdlib>
 #include <fstream>
 #include <cstring> // memcpy
 
@@ -44,4 +45,54 @@ namespace File {
         memcpy(result.data(), raw->data(), raw->size());
         return result;
     }
+
+    std::expected<void, FileError> WriteBinaryFile(const std::filesystem::path& path,
+                                                   const std::span<const std::byte> data) {
+        auto tempPath = path;
+        tempPath += ".tmp";
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                return std::unexpected(FileError{FileError::Type::OpenFailed, path});
+            }
+
+            if (!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())) ||
+                !file.flush()) {
+                std::error_code ignored;
+                std::filesystem::remove(tempPath, ignored);
+                return std::unexpected(FileError{FileError::Type::WriteFailed, path});
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        if (error) {
+            std::filesystem::remove(tempPath, error);
+            return std::unexpected(FileError{FileError::Type::WriteFailed, path});
+        }
+
+        return {};
+    }
+
+    std::filesystem::path GetCacheDirectory() {
+        namespace fs = std::filesystem;
+
+#ifdef _WIN32
+        const char* base = std::getenv("LOCALAPPDATA");
+        fs::path directory = base ? fs::path(base) : fs::temp_directory_path();
+#else
+        const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+        const char* home = std::getenv("HOME");
+        fs::path directory = xdgCache && *xdgCache ? fs::path(xdgCache)
+                             : home ? fs::path(home) / ".cache"
+                             : fs::temp_directory_path();
+#endif
+        directory /= "Vulkan-RayTracer";
+
+        // A missing directory only shows up as a failed write later on
+        std::error_code ignored;
+        fs::create_directories(directory, ignored);
+        return directory;
+    }
 }
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <expected>
 #include <filesystem>
+#include <span>
 #include <vector>
 #include <format>
 
@@ -12,7 +13,9 @@ namespace File {
             NotFound,
             NotAFile,
             OpenFailed,
-            ReadFailed
+            ReadFailed,
+            WriteFailed,
+            UnsupportedFormat
         };
 
         Type type;
@@ -21,6 +24,12 @@ namespace File {
 
     std::expected<std::vector<std::byte>, FileError> ReadBinaryFile(const std::filesystem::path& path);
     std::expected<std::vector<uint32_t>, FileError> ReadSpirvFile(const std::filesystem::path& path);
+
+    // Written next to the path then renamed over it, an interrupted write leaves the previous file intact
+    std::expected<void, FileError> WriteBinaryFile(const std::filesystem::path& path, std::span<const std::byte> data);
+
+    // Per-user directory for data the application can rebuild, created on first use
+    std::filesystem::path GetCacheDirectory();
 }
 
 template <>
@@ -36,6 +45,10 @@ struct std::formatter<File::FileError> : std::formatter<std::string> {
             break;
         case File::FileError::Type::ReadFailed: errorTypeString = "Failed to read file";
             break;
+        case File::FileError::Type::WriteFailed: errorTypeString = "Failed to write file";
+            break;
+        case File::FileError::Type::UnsupportedFormat: errorTypeString = "Unsupported file format";
+            break;
         default: errorTypeString = "Unknown error";
             break;
         }
@@ -0,0 +1,38 @@
+#include "ImageCompare.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace ImageCompare {
+    Difference Compare(const std::span<const float> image, const std::span<const float> reference) {
+        assert(image.size() == reference.size());
+
+        // Keeps near-black reference pixels from dominating the relative error
+        constexpr double relativeEpsilon = 1e-2;
+
+        Difference difference;
+        double squaredError = 0.0;
+        double imageSum = 0.0;
+        double referenceSum = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < image.size(); ++i) {
+            if (i % 4 == 3) continue; // Alpha
+
+            const double error = static_cast<double>(image[i]) - reference[i];
+            squaredError += error * error;
+            difference.relativeMse += error * error / (static_cast<double>(reference[i]) * reference[i] + relativeEpsilon);
+            difference.maxAbsoluteError = std::max(difference.maxAbsoluteError, std::abs(error));
+            imageSum += image[i];
+            referenceSum += reference[i];
+            ++count;
+        }
+
+        if (count == 0) return difference;
+
+        difference.rmse = std::sqrt(squaredError / static_cast<double>(count));
+        difference.relativeMse /= static_cast<double>(count);
+        if (referenceSum > 0.0) difference.relativeBias = imageSum / referenceSum - 1.0;
+        return difference;
+    }
+}
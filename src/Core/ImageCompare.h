@@ -0,0 +1,15 @@
+#pragma once
+
+#include <span>
+
+namespace ImageCompare {
+    struct Difference {
+        double rmse = 0.0;
+        double relativeMse = 0.0;    // Squared error over squared reference, robust to bright pixels
+        double maxAbsoluteError = 0.0;
+        double relativeBias = 0.0; // Mean of the image over the mean of the reference, minus one
+    };
+
+    // Compares the RGB channels of two linear RGBA32F images of the same size
+    Difference Compare(std::span<const float> image, std::span<const float> reference);
+}
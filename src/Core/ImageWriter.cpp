@@ -0,0 +1,227 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using Bytes = std::vector<std::byte>;
+
+    // ---- Little-endian helpers (PFM with a negative scale, EXR) ---- //
+    template <typename T>
+    void AppendLE(Bytes& out, const T value) {
+        static_assert(std::endian::native == std::endian::little, "Writers assume a little-endian host");
+        const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void AppendString(Bytes& out, const std::string_view str, const bool nullTerminated) {
+        const auto* bytes = reinterpret_cast<const std::byte*>(str.data());
+        out.insert(out.end(), bytes, bytes + str.size());
+        if (nullTerminated) out.push_back(std::byte{0});
+    }
+
+    void AppendBE32(Bytes& out, const uint32_t value) {
+        out.push_back(static_cast<std::byte>(value >> 24));
+        out.push_back(static_cast<std::byte>(value >> 16));
+        out.push_back(static_cast<std::byte>(value >> 8));
+        out.push_back(static_cast<std::byte>(value));
+    }
+
+    // ---- PFM ---- //
+    Bytes EncodePFM(const uint32_t width, const uint32_t height, const std::span<const float> rgba) {
+        Bytes out;
+        AppendString(out, std::format("PF\n{} {}\n-1.0\n", width, height), false);
+
+        // Rows are stored bottom to top
+        for (uint32_t y = height; y-- > 0;) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const float* pixel = &rgba[(y * width + x) * 4];
+                AppendLE(out, pixel[0]);
+                AppendLE(out, pixel[1]);
+                AppendLE(out, pixel[2]);
+            }
+        }
+        return out;
+    }
+
+    // ---- PNG (zlib stream made of stored blocks, no compression) ---- //
+    uint32_t Crc32(const std::span<const std::byte> data) {
+        static const auto table = [] {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (const std::byte b : data) crc = table[(crc ^ static_cast<uint8_t>(b)) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    uint32_t Adler32(const std::span<const std::byte> data) {
+        uint32_t a = 1, b = 0;
+        for (const std::byte byte : data) {
+            a = (a + static_cast<uint8_t>(byte)) % 65521;
+            b = (b + a) % 65521;
+        }
+        return b << 16 | a;
+    }
+
+    void AppendChunk(Bytes& out, const std::string_view type, const Bytes& data) {
+        AppendBE32(out, static_cast<uint32_t>(data.size()));
+
+        const size_t typeStart = out.size();
+        AppendString(out, type, false);
+        out.insert(out.end(), data.begin(), data.end());
+
+        AppendBE32(out, Crc32(std::span(out).subspan(typeStart)));
+    }
+
+    Bytes EncodePNG(const uint32_t width, const uint32_t height, const std::span<const float> rgba) {
+        // Filter type 0 then RGB8 for each row
+        Bytes raw;
+        raw.reserve(static_cast<size_t>(height) * (width * 3 + 1));
+        for (uint32_t y = 0; y < height; ++y) {
+            raw.push_back(std::byte{0});
+            for (uint32_t x = 0; x < width; ++x) {
+                const float* pixel = &rgba[(y * width + x) * 4];
+                for (int c = 0; c < 3; ++c) {
+                    const float value = std::clamp(pixel[c], 0.0f, 1.0f);
+                    raw.push_back(static_cast<std::byte>(std::lround(value * 255.0f)));
+                }
+            }
+        }
+
+        Bytes zlib = {std::byte{0x78}, std::byte{0x01}};
+        constexpr size_t maxBlockSize = 0xFFFF;
+        for (size_t offset = 0;; offset += maxBlockSize) {
+            const auto blockSize = static_cast<uint16_t>(std::min(maxBlockSize, raw.size() - offset));
+            const bool last = offset + blockSize >= raw.size();
+
+            zlib.push_back(std::byte{last ? uint8_t{1} : uint8_t{0}});
+            AppendLE(zlib, blockSize);
+            AppendLE(zlib, static_cast<uint16_t>(~blockSize));
+            zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+
+            if (last) break;
+        }
+        AppendBE32(zlib, Adler32(raw));
+
+        Bytes header;
+        AppendBE32(header, width);
+        AppendBE32(header, height);
+        header.insert(header.end(), {
+                          std::byte{8}, // Bit depth
+                          std::byte{2}, // Color type: RGB
+                          std::byte{0}, // Compression
+                          std::byte{0}, // Filter
+                          std::byte{0}, // Interlace
+                      });
+
+        Bytes out = {
+            std::byte{0x89}, std::byte{'P'}, std::byte{'N'}, std::byte{'G'},
+            std::byte{'\r'}, std::byte{'\n'}, std::byte{0x1A}, std::byte{'\n'}
+        };
+        AppendChunk(out, "IHDR", header);
+        AppendChunk(out, "IDAT", zlib);
+        AppendChunk(out, "IEND", {});
+        return out;
+    }
+
+    // ---- OpenEXR (single part scanline, FLOAT channels, no compression) ---- //
+    void AppendAttribute(Bytes& out, const std::string_view name, const std::string_view type, const Bytes& value) {
+        AppendString(out, name, true);
+        AppendString(out, type, true);
+        AppendLE(out, static_cast<int32_t>(value.size()));
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    Bytes EncodeEXR(const uint32_t width, const uint32_t height, const std::span<const float> rgba) {
+        // Channels are stored in alphabetical order
+        constexpr std::array<std::pair<std::string_view, int>, 3> channels = {{{"B", 2}, {"G", 1}, {"R", 0}}};
+        constexpr int32_t floatPixelType = 2;
+
+        Bytes out;
+        AppendLE(out, 20000630); // Magic number
+        AppendLE(out, 2);        // Version 2, single part scanline
+
+        Bytes channelList;
+        for (const auto& [name, _] : channels) {
+            AppendString(channelList, name, true);
+            AppendLE(channelList, floatPixelType);
+            AppendLE(channelList, uint32_t{0}); // pLinear + reserved
+            AppendLE(channelList, int32_t{1});  // xSampling
+            AppendLE(channelList, int32_t{1});  // ySampling
+        }
+        channelList.push_back(std::byte{0});
+        AppendAttribute(out, "channels", "chlist", channelList);
+
+        AppendAttribute(out, "compression", "compression", {std::byte{0}});
+
+        Bytes window;
+        AppendLE(window, int32_t{0});
+        AppendLE(window, int32_t{0});
+        AppendLE(window, static_cast<int32_t>(width) - 1);
+        AppendLE(window, static_cast<int32_t>(height) - 1);
+        AppendAttribute(out, "dataWindow", "box2i", window);
+        AppendAttribute(out, "displayWindow", "box2i", window);
+
+        AppendAttribute(out, "lineOrder", "lineOrder", {std::byte{0}});
+
+        Bytes one;
+        AppendLE(one, 1.0f);
+        AppendAttribute(out, "pixelAspectRatio", "float", one);
+
+        Bytes center;
+        AppendLE(center, 0.0f);
+        AppendLE(center, 0.0f);
+        AppendAttribute(out, "screenWindowCenter", "v2f", center);
+        AppendAttribute(out, "screenWindowWidth", "float", one);
+
+        out.push_back(std::byte{0}); // End of header
+
+        // Without compression every block holds a single scanline
+        const uint32_t lineSize = width * static_cast<uint32_t>(channels.size()) * sizeof(float);
+        const uint64_t firstBlock = out.size() + sizeof(uint64_t) * height;
+        for (uint32_t y = 0; y < height; ++y) {
+            AppendLE(out, firstBlock + static_cast<uint64_t>(y) * (2 * sizeof(int32_t) + lineSize));
+        }
+
+        for (uint32_t y = 0; y < height; ++y) {
+            AppendLE(out, static_cast<int32_t>(y));
+            AppendLE(out, static_cast<int32_t>(lineSize));
+            for (const auto& [_, component] : channels) {
+                for (uint32_t x = 0; x < width; ++x) AppendLE(out, rgba[(y * width + x) * 4 + component]);
+            }
+        }
+        return out;
+    }
+}
+
+namespace ImageWriter {
+    std::expected<void, File::FileError> Write(const std::filesystem::path& path,
+                                               const uint32_t width,
+                                               const uint32_t height,
+                                               const std::span<const float> rgba) {
+        if (rgba.size() < static_cast<size_t>(width) * height * 4) {
+            return std::unexpected(File::FileError{File::FileError::Type::WriteFailed, path});
+        }
+
+        const auto extension = path.extension();
+
+        Bytes encoded;
+        if (extension == ".exr") encoded = EncodeEXR(width, height, rgba);
+        else if (extension == ".pfm") encoded = EncodePFM(width, height, rgba);
+        else if (extension == ".png") encoded = EncodePNG(width, height, rgba);
+        else return std::unexpected(File::FileError{File::FileError::Type::UnsupportedFormat, path});
+
+        return File::WriteBinaryFile(path, encoded);
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+
+#include "Core/File.h"
+
+namespace ImageWriter {
+    // Writes linear RGBA32F pixels, rows from top to bottom. The format follows the extension:
+    // .exr (uncompressed float), .pfm (float) or .png (8-bit, values clamped as on screen).
+    std::expected<void, File::FileError> Write(const std::filesystem::path& path,
+                                               uint32_t width,
+                                               uint32_t height,
+                                               std::span<const float> rgba);
+}
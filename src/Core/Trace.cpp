@@ -0,0 +1,155 @@
+#include "Trace.h"
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Core/Log.h"
+
+namespace {
+    std::atomic<bool> enabled = false;
+
+#ifdef RAYTRACER_TRACING
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        const char* name;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    // Written by its thread only, events are published through count so Save() can read concurrently
+    struct Chunk {
+        static constexpr uint32_t SIZE = 4096;
+
+        std::array<Event, SIZE> events;
+        std::atomic<uint32_t> count = 0;
+        std::atomic<Chunk*> next = nullptr;
+    };
+
+    struct ThreadBuffer {
+        uint32_t threadId;
+        std::unique_ptr<Chunk> head = std::make_unique<Chunk>();
+        Chunk* tail = head.get();
+
+        ~ThreadBuffer() {
+            // The head is owned by the unique_ptr, every following chunk by its predecessor
+            Chunk* chunk = head->next.load();
+            while (chunk) delete std::exchange(chunk, chunk->next.load());
+        }
+    };
+
+    // Buffers outlive their threads, the lock is only taken on registration and on save
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        Clock::time_point origin = Clock::now();
+    };
+
+    Registry& GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadBuffer& GetThreadBuffer() {
+        thread_local ThreadBuffer* buffer = [] {
+            auto& registry = GetRegistry();
+            const std::lock_guard lock(registry.mutex);
+            const auto id = static_cast<uint32_t>(registry.buffers.size());
+            return registry.buffers.emplace_back(new ThreadBuffer{.threadId = id}).get();
+        }();
+        return *buffer;
+    }
+
+    void Record(const char* name, const Clock::time_point start, const Clock::time_point end) {
+        ThreadBuffer& buffer = GetThreadBuffer();
+
+        Chunk* chunk = buffer.tail;
+        uint32_t count = chunk->count.load(std::memory_order_relaxed);
+        if (count == Chunk::SIZE) {
+            auto* next = new Chunk;
+            chunk->next.store(next, std::memory_order_release);
+            buffer.tail = chunk = next;
+            count = 0;
+        }
+
+        chunk->events[count] = {.name = name, .start = start, .end = end};
+        chunk->count.store(count + 1, std::memory_order_release);
+    }
+#endif
+}
+
+namespace Trace {
+    void Start() {
+#ifdef RAYTRACER_TRACING
+        GetRegistry();
+        enabled.store(true, std::memory_order_relaxed);
+#else
+        LOGW("Tracing was compiled out, configure with -DRAYTRACER_TRACING=ON");
+#endif
+    }
+
+    bool IsEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    bool Save(const std::filesystem::path& filepath) {
+#ifdef RAYTRACER_TRACING
+        std::ofstream write(filepath);
+        if (!write.is_open()) {
+            LOGE("Failed to open file: {}", filepath.string());
+            return false;
+        }
+
+        auto& registry = GetRegistry();
+        const std::lock_guard lock(registry.mutex);
+
+        const auto micros = [&](const Clock::time_point t) {
+            return std::chrono::duration<double, std::micro>(t - registry.origin).count();
+        };
+
+        // Complete events ("X"), one per line to keep large traces diffable
+        size_t eventCount = 0;
+        write << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        for (const auto& buffer : registry.buffers) {
+            for (const Chunk* chunk = buffer->head.get(); chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+                const uint32_t count = chunk->count.load(std::memory_order_acquire);
+                for (uint32_t i = 0; i < count; ++i) {
+                    const auto& [name, start, end] = chunk->events[i];
+                    const nlohmann::json event = {
+                        {"name", name},
+                        {"ph", "X"},
+                        {"ts", micros(start)},
+                        {"dur", micros(end) - micros(start)},
+                        {"pid", 1},
+                        {"tid", buffer->threadId},
+                    };
+                    write << (eventCount++ ? ",\n" : "") << event.dump();
+                }
+            }
+        }
+        write << "\n]}" << std::endl;
+
+        LOGI("Saved trace with {} zones: {}", eventCount, filepath.string());
+        return true;
+#else
+        LOGW("Tracing was compiled out, {} not written", filepath.string());
+        return false;
+#endif
+    }
+
+#ifdef RAYTRACER_TRACING
+    Zone::Zone(const char* name) : name(enabled.load(std::memory_order_relaxed) ? name : nullptr) {
+        if (this->name) start = Clock::now();
+    }
+
+    Zone::~Zone() {
+        if (name) Record(name, start, Clock::now());
+    }
+#endif
+}
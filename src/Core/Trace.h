@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+
+// CPU zones exported as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+// Each thread appends to its own buffer without locking. Zones cost one relaxed load until Start().
+namespace Trace {
+    void Start();
+    bool IsEnabled();
+
+    // Writes every zone recorded so far, zones still being recorded by other threads may be missing
+    bool Save(const std::filesystem::path& filepath);
+
+#ifdef RAYTRACER_TRACING
+    // name must outlive the trace: use string literals
+    class Zone {
+    public:
+        explicit Zone(const char* name);
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+    };
+#endif
+}
+
+#ifdef RAYTRACER_TRACING
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) const Trace::Zone TRACE_CONCAT(traceZone, __COUNTER__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
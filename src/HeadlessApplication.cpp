@@ -0,0 +1,81 @@
+#include "HeadlessApplication.h"
+
+#include "Core/ImageCompare.h"
+#include "Core/ImageWriter.h"
+#include "Core/Log.h"
+
+HeadlessApplication::HeadlessApplication(const CommandLine::Options& options) : options(options) {
+    raytracer = std::make_unique<Raytracer>(options.width, options.height);
+
+    if (!options.cpu) {
+        try {
+            vulkanContext = std::make_shared<VulkanContext>(nullptr);
+            renderer = std::make_unique<HeadlessRenderer>(vulkanContext);
+        } catch (const std::exception& e) {
+            if (options.compare) {
+                LOGE("Failed to initialize headless renderer: {}", e.what());
+                std::exit(EXIT_FAILURE);
+            }
+
+            LOGW("No usable Vulkan device ({}), falling back to the CPU renderer", e.what());
+            renderer.reset();
+            vulkanContext.reset();
+        }
+    }
+
+    if (!renderer || options.compare) cpuRenderer = std::make_unique<CpuRenderer>(options.threads);
+}
+
+int HeadlessApplication::Run() const {
+    if (!raytracer->LoadFromFile(options.scene)) return EXIT_FAILURE;
+    CommandLine::ApplyOverrides(options, raytracer->GetSettings());
+
+    const OfflineRenderResult result = renderer
+                                           ? renderer->Render(*raytracer, options.samples)
+                                           : cpuRenderer->Render(*raytracer, options.samples);
+
+    if (renderer) {
+        LOGI("Rendered {}x{} at {} spp with the {} integrator in {:.3f} s (scene upload {:.3f} s)",
+             result.width, result.height, options.samples, ToString(raytracer->GetSettings().integrator),
+             result.renderSeconds, result.uploadSeconds);
+    } else {
+        LOGI("Rendered {}x{} at {} spp on {} CPU threads in {:.3f} s",
+             result.width, result.height, options.samples, cpuRenderer->GetThreadCount(), result.renderSeconds);
+    }
+    LOGI("Traced {} rays, {:.2f} Mrays/s", result.rays, result.rays / result.renderSeconds * 1e-6);
+
+    if (options.compare) CompareWithReference(result);
+
+    if (const auto written = ImageWriter::Write(options.output, result.width, result.height, result.pixels);
+        !written) {
+        LOGE("{}", written.error());
+        return EXIT_FAILURE;
+    }
+
+    LOGI("Saved image: {}", options.output.string());
+    return EXIT_SUCCESS;
+}
+
+void HeadlessApplication::CompareWithReference(const OfflineRenderResult& image) const {
+    // Same seeds on both sides: differences come from floating point, amplified along diverging paths
+    const OfflineRenderResult reference = cpuRenderer->Render(*raytracer, options.samples);
+    LOGI("CPU reference rendered on {} threads in {:.3f} s, {:.2f} Mrays/s",
+         cpuRenderer->GetThreadCount(), reference.renderSeconds, reference.rays / reference.renderSeconds * 1e-6);
+
+    const auto difference = ImageCompare::Compare(image.pixels, reference.pixels);
+    LOGI("GPU against CPU reference: RMSE {:.6f}, relative MSE {:.6f}, max error {:.4f}, rays {} / {}",
+         difference.rmse, difference.relativeMse, difference.maxAbsoluteError, image.rays, reference.rays);
+
+    // Light sampling only changes the noise: against paths that find lights by bouncing into them, a brighter or
+    // darker mean points at the light list or its pdf. Emissive meshes are the case worth running this on.
+    RenderSettings& settings = raytracer->GetSettings();
+    if (!settings.lightSampling) return;
+
+    settings.lightSampling = false;
+    const OfflineRenderResult bounces = cpuRenderer->Render(*raytracer, options.samples);
+    settings.lightSampling = true;
+
+    LOGI("Light sampling against bounces only: mean {:+.3f} % on the GPU, {:+.3f} % on the CPU",
+         ImageCompare::Compare(image.pixels, bounces.pixels).relativeBias * 100.0,
+         ImageCompare::Compare(reference.pixels, bounces.pixels).relativeBias * 100.0);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Core/CommandLine.h"
+#include "Vulkan/VulkanContext.h"
+#include "Renderer/CpuRenderer.h"
+#include "Renderer/HeadlessRenderer.h"
+#include "Raytracer/Raytracer.h"
+
+// Offline counterpart of Application: renders a scene file to an image, then exits.
+// Falls back to the CPU renderer when no Vulkan device is usable.
+class HeadlessApplication {
+public:
+    explicit HeadlessApplication(const CommandLine::Options& options);
+    ~HeadlessApplication() = default;
+
+    // Returns the process exit code
+    int Run() const;
+
+private:
+    void CompareWithReference(const OfflineRenderResult& image) const;
+
+private:
+    CommandLine::Options options;
+
+    std::shared_ptr<VulkanContext> vulkanContext;
+    std::unique_ptr<HeadlessRenderer> renderer; // Null when rendering on the CPU only
+    std::unique_ptr<CpuRenderer> cpuRenderer;   // Null when rendering on the GPU only
+    std::unique_ptr<Raytracer> raytracer;
+};
@@ -6,6 +6,8 @@
 #include <glm/glm.hpp>
 #include <glm/ext/vector_common.hpp>
 
+#include "Core/Trace.h"
+
 size_t BVH_Node::Depth() const {
     if (left && right) return 1 + std::max(left->Depth(), right->Depth());
     if (left) return 1 + left->Depth();
@@ -18,7 +20,7 @@ BVH_Node::~BVH_Node() {
     delete right;
 }
 
-size_t BVH_Node::Flatten(std::vector<BVH_FlattenNode>& nodes) const {
+size_t BVH_Node::Flatten(std::vector<BVH_FlattenNode>& nodes, std::vector<Triangle>& leafTriangles) const {
     const auto flat = BVH_FlattenNode{
         .bbox = bbox,
         .start = 0,
@@ -28,8 +30,15 @@ size_t BVH_Node::Flatten(std::vector<BVH_FlattenNode>& nodes) const {
     nodes.push_back(flat);
     const size_t idx = nodes.size() - 1;
 
-    if (left) nodes[idx].left = left->Flatten(nodes);
-    if (right) nodes[idx].right = right->Flatten(nodes);
+    if (left) nodes[idx].left = left->Flatten(nodes, leafTriangles);
+    if (right) nodes[idx].right = right->Flatten(nodes, leafTriangles);
+
+    // The cuts partition the triangles, a leaf's box is the bounds of its own ones
+    if (!left && !right) {
+        nodes[idx].start = static_cast<uint32_t>(leafTriangles.size());
+        nodes[idx].count = static_cast<uint32_t>(triangles.size());
+        leafTriangles.insert(leafTriangles.end(), triangles.begin(), triangles.end());
+    }
 
     return idx;
 }
@@ -37,6 +46,8 @@ size_t BVH_Node::Flatten(std::vector<BVH_FlattenNode>& nodes) const {
 BVH::BVH(const std::vector<Triangle>& triangles, const size_t maxDepth) {
     assert(triangles.size() >= 2);
 
+    TRACE_SCOPE("BVH::Build");
+
     root = new BVH_Node({.triangles = triangles});
     ComputeNode(root, 0, maxDepth);
 }
@@ -46,25 +57,13 @@ BVH::~BVH() {
 }
 
 BVH_Scene BVH::ToGPUData() const {
+    TRACE_SCOPE("BVH::ToGPUData");
+
     BVH_Scene scene;
     if (!root) return scene;
 
-    root->Flatten(scene.nodes);
-
-    const auto& triangles = root->triangles;
-    scene.triangles.reserve(triangles.size());
-
-    std::vector<Triangle> trianglesInBbox;
-    trianglesInBbox.reserve(triangles.size());
-
-    for (auto& [bbox, left, right, start, count] : scene.nodes) {
-        if (left != 0 || right != 0) continue;
-
-        ComputeTrianglesInBoundingBox(triangles, bbox, trianglesInBbox);
-        start = scene.triangles.size();
-        count = trianglesInBbox.size();
-        scene.triangles.insert(scene.triangles.end(), trianglesInBbox.begin(), trianglesInBbox.end());
-    }
+    scene.triangles.reserve(root->triangles.size());
+    root->Flatten(scene.nodes, scene.triangles);
 
     return scene;
 }
@@ -82,6 +81,8 @@ BoundingBox BVH::ComputeBoundingBox(const std::vector<Triangle>& triangles) {
 }
 
 Cut BVH::ComputeCut(const std::vector<Triangle>& triangles, const BoundingBox& bbox) {
+    TRACE_SCOPE("BVH::ComputeCut");
+
     const glm::vec3 dimensions = bbox.max - bbox.min;
     const uint8_t cutIdx = (dimensions.x >= dimensions.y && dimensions.x >= dimensions.z)
                                ? 0
@@ -117,22 +118,6 @@ void BVH::ComputeNode(BVH_Node* node, const uint32_t depth, const uint32_t maxDe
     ComputeNode(node->left, depth + 1, maxDepth);
 }
 
-void BVH::ComputeTrianglesInBoundingBox(const std::vector<Triangle>& triangles,
-                                        const BoundingBox& bb,
-                                        std::vector<Triangle>& out) {
-    out.clear();
-    for (const auto& triangle : triangles) {
-        if (glm::min(triangle.a, triangle.b, triangle.c, bb.min) == bb.min &&
-            glm::max(triangle.a, triangle.b, triangle.c, bb.max) == bb.max) {
-            out.push_back({
-                .a = triangle.a,
-                .b = triangle.b,
-                .c = triangle.c
-            });
-        }
-    }
-}
-
 glm::vec3 BVH::GetCenter(const Triangle& triangle) {
     return {
         (triangle.a.x + triangle.b.x + triangle.c.x) / 3.f,
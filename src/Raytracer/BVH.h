@@ -18,7 +18,8 @@ struct BVH_Node {
     size_t Depth() const;
     ~BVH_Node();
 
-    size_t Flatten(std::vector<BVH_FlattenNode>& nodes) const;
+    // Leaves append their own triangles, each triangle of the tree ends up in exactly one leaf
+    size_t Flatten(std::vector<BVH_FlattenNode>& nodes, std::vector<Triangle>& leafTriangles) const;
 };
 
 struct BVH_Scene {
@@ -43,10 +44,6 @@ private:
     static Cut ComputeCut(const std::vector<Triangle>& triangles, const BoundingBox& bbox);
     static void ComputeNode(BVH_Node* node, uint32_t depth, uint32_t maxDepth);
 
-    static void ComputeTrianglesInBoundingBox(const std::vector<Triangle>& triangles,
-                                              const BoundingBox& bb,
-                                              std::vector<Triangle>& out);
-
     static glm::vec3 GetCenter(const Triangle& triangle);
 
 private:
@@ -0,0 +1,40 @@
+#include "CameraPath.h"
+
+#include <fstream>
+
+#include "Serialize/Serialize.h"
+#include "Core/Log.h"
+#include "Core/Trace.h"
+
+bool CameraPath::LoadFromFile(const std::filesystem::path& filepath) {
+    TRACE_SCOPE("CameraPath::LoadFromFile");
+
+    std::ifstream read(filepath);
+    if (!read.is_open()) {
+        LOGE("Failed to open file: {}", filepath.string());
+        return false;
+    }
+
+    try {
+        from_json(Json::parse(read), *this);
+    } catch (const Json::exception& e) {
+        LOGE("Failed to parse camera path: {}", e.what());
+        return false;
+    }
+
+    LOGI("Loaded camera path with {} keyframes: {}", keyframes.size(), filepath.string());
+    return true;
+}
+
+void CameraPath::SaveToFile(const std::filesystem::path& filepath) const {
+    TRACE_SCOPE("CameraPath::SaveToFile");
+
+    std::ofstream write(filepath);
+    if (!write.is_open()) {
+        LOGE("Failed to open file: {}", filepath.string());
+        return;
+    }
+
+    write << std::setw(4) << static_cast<Json>(*this) << std::endl;
+    LOGI("Saved camera path with {} keyframes: {}", keyframes.size(), filepath.string());
+}
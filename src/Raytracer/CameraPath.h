@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "Camera.h"
+#include "Serialize/Base.h"
+
+// Ordered camera poses, recorded from the camera controller or written by hand as a keyframe list
+class CameraPath {
+public:
+    Serializable(CameraPath);
+
+    bool LoadFromFile(const std::filesystem::path& filepath);
+    void SaveToFile(const std::filesystem::path& filepath) const;
+
+    void AddKeyframe(const Camera& camera) { keyframes.push_back(camera); }
+    void Clear() { keyframes.clear(); }
+
+    const std::vector<Camera>& GetKeyframes() const { return keyframes; }
+    size_t Size() const { return keyframes.size(); }
+    bool Empty() const { return keyframes.empty(); }
+
+private:
+    std::vector<Camera> keyframes;
+};
@@ -26,7 +26,15 @@ struct alignas(16) SceneData {
     uint32_t numTriangles;
     uint32_t numSpheres;
     uint32_t numMeshes;
+    uint32_t bvhDepth; // Deepest mesh BVH, edges from the root to the farthest leaf
+
+    // Union of the mesh and sphere bounds, zero for an empty scene
+    glm::vec3 boundsMin;
     PAD(1);
+    glm::vec3 boundsMax;
+    uint32_t numLights;
+    float lightPower; // Summed LightPower() of the lights, normalizes their selection probability
+    PAD(3);
 };
 
 struct alignas(16) Material {
@@ -74,4 +82,81 @@ struct alignas(16) Sphere {
     Material mat;
 };
 
+// Emissive sphere or mesh triangle, picked for next-event estimation in proportion to its power
+struct Light {
+    uint32_t primitive; // Sphere index, or triangle index for mesh lights
+    uint32_t material;  // Sphere index, or numSpheres + mesh index
+    float cdf;          // Normalized power of the lights up to this one included
+};
+
+// Bounce limit of the render settings, sizes the per-bounce counters of the wavefront integrator
+constexpr uint32_t MAX_BOUNCES = 16;
+
+// Written by the compute shader, 64-bit counter split in two words
+struct RayStats {
+    uint32_t rayCountLow;
+    uint32_t rayCountHigh;
+};
+
+// Adaptive sampling: the running luminance moment of each pixel, next to its mean in the accumulation buffer.
+// Pixels count their own samples, the tiles they belong to may get more or fewer than the others.
+struct PixelStats {
+    float lumSquared; // Mean of the squared luminance of the samples
+    uint32_t samples;
+};
+
+// Pixels per side of the tiles the adaptive mask is built for, a megakernel workgroup
+constexpr uint32_t ADAPTIVE_TILE_SIZE = 16;
+
+// Values of the adaptiveSampling push constant, see common.glsl
+constexpr uint32_t ADAPTIVE_OFF = 0;
+constexpr uint32_t ADAPTIVE_STATS = 1;
+constexpr uint32_t ADAPTIVE_MASK = 2;
+
+// Written by the adaptive mask pass, read back by the host to stop once every tile converged
+struct AdaptiveStats {
+    uint32_t activeTiles;
+    uint32_t pixelSamplesLow; // Samples of every pixel summed, 64-bit counter split in two words
+    uint32_t pixelSamplesHigh;
+};
 
+// Wavefront integrator state, only accessed by the GPU: the structs give the buffer sizes and indirect offsets
+struct alignas(16) PathState {
+    glm::vec3 throughput;
+    uint32_t seed;
+    glm::vec3 radiance;
+    float bsdfPdf;
+};
+
+struct alignas(16) QueuedRay {
+    glm::vec3 ori;
+    uint32_t path;
+    glm::vec3 dir;
+    PAD(1);
+};
+
+struct alignas(16) QueuedHit {
+    glm::vec3 normal;
+    float dst;
+    uint32_t ray;
+    uint32_t material; // Sphere index, or numSpheres + mesh index
+    uint32_t triangle;
+    PAD(1);
+};
+
+struct DispatchArgs {
+    uint32_t x;
+    uint32_t y;
+    uint32_t z;
+};
+
+// Queue sizes per bounce, and the indirect dispatches derived from them
+struct WavefrontCounters {
+    uint32_t rays[MAX_BOUNCES];
+    uint32_t hits[MAX_BOUNCES];
+    uint32_t misses[MAX_BOUNCES];
+    DispatchArgs extendArgs[MAX_BOUNCES];
+    DispatchArgs shadeArgs[MAX_BOUNCES];
+    DispatchArgs missArgs[MAX_BOUNCES];
+    DispatchArgs sortArgs[MAX_BOUNCES];
+};
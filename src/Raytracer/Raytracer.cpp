@@ -4,6 +4,7 @@
 
 #include "Serialize/Serialize.h"
 #include "Core/Log.h"
+#include "Core/Trace.h"
 
 Raytracer::Raytracer(const uint32_t width, const uint32_t height) : width(width),
                                                                     height(height),
@@ -11,15 +12,18 @@ Raytracer::Raytracer(const uint32_t width, const uint32_t height) : width(width)
     SetAllDirty();
 }
 
-void Raytracer::LoadFromFile(const std::filesystem::path& filepath) {
+bool Raytracer::LoadFromFile(const std::filesystem::path& filepath) {
+    TRACE_SCOPE("Raytracer::LoadFromFile");
+
     if (filepath.extension() != ".json") {
         LOGE("Loading only support json file");
-        return;
+        return false;
     }
 
     std::ifstream read(filepath);
     if (!read.is_open()) {
         LOGE("Failed to open file: {}", filepath.string());
+        return false;
     } else {
         try {
             const Json r = Json::parse(read);
@@ -27,14 +31,19 @@ void Raytracer::LoadFromFile(const std::filesystem::path& filepath) {
             LOGI("Successfully loaded file: {}", filepath.string());
             SetAllDirty();
         } catch (const Json::exception& e) {
-            LOGE("Failed to parse JSON: {}", e.what());
+            LOGE("Failed to load {}: {}", filepath.string(), e.what());
+            return false;
         }
 
         read.close();
     }
+
+    return true;
 }
 
 void Raytracer::SaveToFile(const std::filesystem::path& filepath) {
+    TRACE_SCOPE("Raytracer::SaveToFile");
+
     if (filepath.extension() != ".json") {
         LOGE("Loading only support json file");
         return;
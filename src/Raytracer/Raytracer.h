@@ -3,6 +3,7 @@
 
 #include "Core/DirtySystem.h"
 #include "Camera.h"
+#include "RenderSettings.h"
 #include "Scene.h"
 
 enum class DirtyFlags {
@@ -13,16 +14,17 @@ enum class DirtyFlags {
     Triangles = 4,
     BVH_Nodes = 5,
     Spheres = 6,
+    Settings = 7,
 };
 
-class Raytracer : public DirtySystem<DirtyFlags, 7> {
+class Raytracer : public DirtySystem<DirtyFlags, 8> {
 public:
     Serializable(Raytracer);
 
     Raytracer(uint32_t width, uint32_t height);
     ~Raytracer() = default;
 
-    void LoadFromFile(const std::filesystem::path& filepath);
+    bool LoadFromFile(const std::filesystem::path& filepath);
     void SaveToFile(const std::filesystem::path& filepath);
 
     void Update(uint32_t newWidth, uint32_t newHeight);
@@ -33,6 +35,10 @@ public:
     Scene& GetScene() { return scene; }
     const Scene& GetScene() const { return scene; }
 
+    // Set DirtyFlags::Settings after a change, accumulation restarts unless only display or scheduling changed
+    RenderSettings& GetSettings() { return settings; }
+    const RenderSettings& GetSettings() const { return settings; }
+
     uint32_t GetWidth() const { return width; }
     uint32_t GetHeight() const { return height; }
 
@@ -41,4 +47,5 @@ private:
     uint32_t height;
     Camera camera;
     Scene scene;
+    RenderSettings settings;
 };
@@ -0,0 +1,76 @@
+#include "RenderSettings.h"
+
+#include <algorithm>
+
+const char* ToString(const Integrator integrator) {
+    switch (integrator) {
+    case Integrator::Megakernel:
+        return "megakernel";
+    case Integrator::Wavefront:
+        return "wavefront";
+    case Integrator::Persistent:
+        return "persistent";
+    }
+    return "unknown";
+}
+
+std::optional<Integrator> ParseIntegrator(const std::string_view name) {
+    for (const Integrator integrator : INTEGRATORS) {
+        if (name == ToString(integrator)) return integrator;
+    }
+    return std::nullopt;
+}
+
+const char* ToString(const SampleSequence sequence) {
+    switch (sequence) {
+    case SampleSequence::WhiteNoise:
+        return "white-noise";
+    case SampleSequence::Sobol:
+        return "sobol";
+    }
+    return "unknown";
+}
+
+std::optional<SampleSequence> ParseSampleSequence(const std::string_view name) {
+    for (const SampleSequence sequence : SAMPLE_SEQUENCES) {
+        if (name == ToString(sequence)) return sequence;
+    }
+    return std::nullopt;
+}
+
+const char* ToString(const TileOrder order) {
+    switch (order) {
+    case TileOrder::Spiral:
+        return "spiral";
+    case TileOrder::Hilbert:
+        return "hilbert";
+    }
+    return "unknown";
+}
+
+std::optional<TileOrder> ParseTileOrder(const std::string_view name) {
+    for (const TileOrder order : TILE_ORDERS) {
+        if (name == ToString(order)) return order;
+    }
+    return std::nullopt;
+}
+
+uint32_t RouletteDepth(const RenderSettings& settings) {
+    if (!settings.russianRoulette) return 0;
+    return std::clamp(settings.rouletteMinDepth, 1u, MAX_BOUNCES);
+}
+
+bool RestartsAccumulation(const RenderSettings& previous, const RenderSettings& current) {
+    const auto traced = [](RenderSettings settings) {
+        const RenderSettings defaults;
+        settings.samplesPerDispatch = defaults.samplesPerDispatch;
+        settings.frameBudgetMs = defaults.frameBudgetMs;
+        settings.maxSamples = defaults.maxSamples;
+        settings.toneMapping = defaults.toneMapping;
+        settings.tileBudgetMs = defaults.tileBudgetMs;
+        settings.tileOrder = defaults.tileOrder;
+        settings.motionFrameMs = defaults.motionFrameMs;
+        return settings;
+    };
+    return traced(previous) != traced(current);
+}
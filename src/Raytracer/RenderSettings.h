@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "ComputeData.h"
+
+// How the compute pipeline schedules path tracing, the image converges to the same result
+enum class Integrator {
+    Megakernel, // One invocation per pixel runs every bounce
+    Wavefront,  // One kernel per stage, rays flow through queues between them
+    Persistent, // Megakernel on a fixed set of workgroups pulling pixel batches from a global queue
+};
+
+constexpr std::array INTEGRATORS = {Integrator::Megakernel, Integrator::Wavefront, Integrator::Persistent};
+
+const char* ToString(Integrator integrator);
+std::optional<Integrator> ParseIntegrator(std::string_view name);
+
+// Random numbers the path tracer draws its samples from
+enum class SampleSequence {
+    WhiteNoise, // Hashed seed per pixel and sample
+    Sobol,      // Owen-scrambled Sobol points per pixel, stratified across the samples of the pixel
+};
+
+constexpr std::array SAMPLE_SEQUENCES = {SampleSequence::WhiteNoise, SampleSequence::Sobol};
+
+const char* ToString(SampleSequence sequence);
+std::optional<SampleSequence> ParseSampleSequence(std::string_view name);
+
+// Order in which the tile scheduler covers the image, the first tiles show up after a restart first
+enum class TileOrder {
+    Spiral,  // Rings around the centre of the image, where the subject usually is
+    Hilbert, // Along a Hilbert curve, consecutive tiles share their edges
+};
+
+constexpr std::array TILE_ORDERS = {TileOrder::Spiral, TileOrder::Hilbert};
+
+const char* ToString(TileOrder order);
+std::optional<TileOrder> ParseTileOrder(std::string_view name);
+
+// Samples one dispatch may accumulate per pixel before writing the image
+constexpr uint32_t MAX_SAMPLES_PER_DISPATCH = 64;
+
+struct RenderSettings {
+    Integrator integrator = Integrator::Megakernel;
+    uint32_t maxBounces = 5; // In [1, MAX_BOUNCES]
+    bool sortRays = false;   // Wavefront only: reorders secondary rays for coherence before tracing them
+
+    // Russian roulette: after the minimum depth, paths end with a probability tied to their throughput
+    bool russianRoulette = false;
+    uint32_t rouletteMinDepth = 3; // In [1, MAX_BOUNCES]
+
+    // Next-event estimation: diffuse hits also sample the emissive spheres and meshes through a shadow ray
+    bool lightSampling = true;
+
+    SampleSequence sampleSequence = SampleSequence::Sobol;
+
+    // Adaptive sampling: converged tiles stop sampling, noisy ones get more, the GPU idles once all converged
+    bool adaptiveSampling = false;
+    float adaptiveThreshold = 0.02f; // Relative standard error of the pixel means, in (0, 1]
+    uint32_t adaptiveMinSamples = 16; // Per pixel, before their error is trusted
+
+    uint32_t samplesPerDispatch = 1; // In [1, MAX_SAMPLES_PER_DISPATCH]
+    float frameBudgetMs = 0.0f;      // Interactive only: adapts the samples per dispatch to it, 0 keeps them fixed
+    uint32_t maxSamples = 1024;      // Interactive only: the accumulation stops there until a restart, 0 never stops
+
+    bool toneMapping = false; // Interactive only: filmic curve on the display image instead of a clamp
+
+    // Interactive megakernel only: each frame traces the tiles that fit the budget, full frames when 0
+    float tileBudgetMs = 0.0f;
+    TileOrder tileOrder = TileOrder::Spiral;
+
+    // Interactive only: while the camera moves, the render scale drops until tracing fits it, 0 keeps full resolution
+    float motionFrameMs = 0.0f;
+
+    bool operator==(const RenderSettings&) const = default;
+};
+
+// Whether the change leads to another converged image. Display and scheduling settings keep the accumulation.
+bool RestartsAccumulation(const RenderSettings& previous, const RenderSettings& current);
+
+// Bounces before Russian roulette starts, 0 when disabled, as passed to the kernels
+uint32_t RouletteDepth(const RenderSettings& settings);
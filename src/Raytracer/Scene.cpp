@@ -1,9 +1,21 @@
 #include "Scene.h"
 
+#include <chrono>
+#include <numbers>
+
 #include "Extern/objload.h"
 
 #include "Core/Log.h"
 #include "Core/Math.h"
+#include "Core/Trace.h"
+
+namespace {
+    // LightPower() of common.glsl: lights are picked in proportion to it
+    float LightPower(const Material& mat, const float area) {
+        const glm::vec3 emitted = mat.emissionColor * mat.emissionStrength;
+        return (emitted.r + emitted.g + emitted.b) / 3.0f * area;
+    }
+}
 
 Scene::Scene() {
     spheres.emplace_back(Sphere{
@@ -58,7 +70,143 @@ void Scene::RemoveSphere(const uint32_t idx) {
     spheres.erase(spheres.begin() + idx);
 }
 
-const SceneData& Scene::GetSceneData() const {
+bool Scene::AddMesh(const std::filesystem::path& path, const Material& material) {
+    const auto filePath = path.is_relative() ? ASSETS_PATH / path : path;
+    if (!std::filesystem::is_regular_file(filePath)) {
+        LOGE("Mesh file not found: {}", filePath.string());
+        return false;
+    }
+
+    std::vector<Triangle> meshTriangles;
+    {
+        TRACE_SCOPE("Scene::ParseOBJ");
+
+        const obj::Model model = obj::loadModelFromFile(filePath.string());
+        const auto vertex = [&](const unsigned short index) {
+            return glm::vec3(model.vertex[3 * index], model.vertex[3 * index + 1], model.vertex[3 * index + 2]);
+        };
+
+        // objload files every face under "default" as well as under its named groups
+        if (const auto faces = model.faces.find("default"); faces != model.faces.end()) {
+            const auto& indices = faces->second;
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                meshTriangles.push_back({
+                    .a = vertex(indices[i]),
+                    .b = vertex(indices[i + 1]),
+                    .c = vertex(indices[i + 2]),
+                });
+            }
+        }
+    }
+
+    if (meshTriangles.size() < 2) {
+        LOGE("Mesh {} needs at least 2 triangles", filePath.string());
+        return false;
+    }
+
+    const auto buildStart = std::chrono::steady_clock::now();
+    const BVH tree(meshTriangles);
+    const BVH_Scene bvh = tree.ToGPUData();
+    const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    bvhBuildMs += buildMs;
+    bvhDepth = std::max(bvhDepth, static_cast<uint32_t>(tree.GetMaxDepth()));
+
+    // Node and triangle indices are local to the mesh, shift them past the existing ones
+    const auto nodeOffset = static_cast<uint32_t>(bvhNodes.size());
+    const auto triangleOffset = static_cast<uint32_t>(triangles.size());
+    for (BVH_FlattenNode node : bvh.nodes) {
+        if (node.left != 0 || node.right != 0) {
+            node.left += nodeOffset;
+            node.right += nodeOffset;
+        } else {
+            node.start += triangleOffset;
+        }
+        bvhNodes.push_back(node);
+    }
+    triangles.insert(triangles.end(), bvh.triangles.begin(), bvh.triangles.end());
+    meshTriangleEnds.push_back(static_cast<uint32_t>(triangles.size()));
+
+    meshes.push_back({.start = nodeOffset, .mat = material});
+    meshPaths.push_back(path);
+
+    LOGI("Loaded mesh {}: {} triangles, {} BVH nodes, built in {:.2f} ms",
+         path.string(), meshTriangles.size(), bvh.nodes.size(), buildMs);
+    return true;
+}
+
+void Scene::ClearMeshes() {
+    meshes.clear();
+    meshPaths.clear();
+    triangles.clear();
+    meshTriangleEnds.clear();
+    bvhNodes.clear();
+    bvhBuildMs = 0.0;
+    bvhDepth = 0;
+}
+
+SceneData Scene::GetSceneData() const {
+    SceneData sceneData = {};
     sceneData.numSpheres = spheres.size();
+    sceneData.numMeshes = meshes.size();
+    sceneData.numTriangles = triangles.size();
+    sceneData.bvhDepth = bvhDepth;
+
+    auto boundsMin = glm::vec3(FLT_MAX);
+    auto boundsMax = glm::vec3(-FLT_MAX);
+    for (const Mesh& mesh : meshes) {
+        boundsMin = glm::min(boundsMin, bvhNodes[mesh.start].bbox.min);
+        boundsMax = glm::max(boundsMax, bvhNodes[mesh.start].bbox.max);
+    }
+    for (const Sphere& sphere : spheres) {
+        boundsMin = glm::min(boundsMin, sphere.pos - sphere.rad);
+        boundsMax = glm::max(boundsMax, sphere.pos + sphere.rad);
+    }
+
+    const bool empty = meshes.empty() && spheres.empty();
+    sceneData.boundsMin = empty ? glm::vec3(0.0f) : boundsMin;
+    sceneData.boundsMax = empty ? glm::vec3(0.0f) : boundsMax;
+
+    const std::vector<Light> lights = CollectLights();
+    sceneData.numLights = lights.size();
+    sceneData.lightPower = lights.empty() ? 0.0f : lights.back().cdf;
     return sceneData;
 }
+
+std::vector<Light> Scene::GetLights() const {
+    std::vector<Light> lights = CollectLights();
+    if (lights.empty()) return lights;
+
+    // The last entry is exactly 1, a selection sample in [0, 1) always finds a light
+    const float lightPower = lights.back().cdf;
+    for (Light& light : lights) light.cdf /= lightPower;
+    lights.back().cdf = 1.0f;
+    return lights;
+}
+
+std::vector<Light> Scene::CollectLights() const {
+    std::vector<Light> lights;
+    float lightPower = 0.0f;
+    const auto addLight = [&](const uint32_t primitive, const uint32_t material, const float power) {
+        if (power <= 0.0f) return;
+        lightPower += power;
+        lights.push_back({.primitive = primitive, .material = material, .cdf = lightPower});
+    };
+
+    for (uint32_t i = 0; i < spheres.size(); ++i) {
+        const Sphere& sphere = spheres[i];
+        addLight(i, i, LightPower(sphere.mat, 4.0f * std::numbers::pi_v<float> * sphere.rad * sphere.rad));
+    }
+
+    // Leaves hold each triangle of their mesh once, the mesh's range lists every source triangle exactly once
+    for (uint32_t m = 0; m < meshes.size(); ++m) {
+        const auto material = static_cast<uint32_t>(spheres.size()) + m;
+        if (LightPower(meshes[m].mat, 1.0f) <= 0.0f) continue;
+
+        for (uint32_t t = m == 0 ? 0 : meshTriangleEnds[m - 1]; t < meshTriangleEnds[m]; ++t) {
+            const Triangle& triangle = triangles[t];
+            const float area = 0.5f * glm::length(glm::cross(triangle.b - triangle.a, triangle.c - triangle.a));
+            addLight(t, material, LightPower(meshes[m].mat, area));
+        }
+    }
+    return lights;
+}
@@ -17,7 +17,17 @@ public:
     void AddSphere();
     void RemoveSphere(uint32_t idx);
 
-    const SceneData& GetSceneData() const;
+    // Loads an OBJ file and builds its BVH. Relative paths are resolved against the assets directory.
+    bool AddMesh(const std::filesystem::path& path, const Material& material);
+    void ClearMeshes();
+
+    // Time spent building BVHs since the last ClearMeshes()
+    double GetBVHBuildMs() const { return bvhBuildMs; }
+
+    SceneData GetSceneData() const;
+
+    // Emissive spheres and mesh triangles, built on every call so that edited materials are picked up
+    std::vector<Light> GetLights() const;
 
     const std::vector<Sphere>& GetSpheres() const { return spheres; }
     const std::vector<Mesh>& GetMeshes() const { return meshes; }
@@ -27,10 +37,17 @@ public:
     std::vector<Sphere>& GetSpheres() { return spheres; }
 
 private:
-    mutable SceneData sceneData = {};
+    // Lights with the running sum of their power in cdf, the last one holds the total
+    std::vector<Light> CollectLights() const;
 
+private:
     std::vector<Mesh> meshes;
+    std::vector<std::filesystem::path> meshPaths; // As given to AddMesh(), saved with the scene
     std::vector<Triangle> triangles;
+    std::vector<uint32_t> meshTriangleEnds; // One past the last triangle of every mesh
     std::vector<BVH_FlattenNode> bvhNodes;
     std::vector<Sphere> spheres;
+
+    double bvhBuildMs = 0.0;
+    uint32_t bvhDepth = 0;
 };
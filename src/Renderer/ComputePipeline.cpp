@@ -1,128 +1,732 @@
 #include "ComputePipeline.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <span>
+
+#include "Core/Log.h"
+#include "Core/Trace.h"
 #include "Vulkan/DescriptorSet.h"
 
-ComputePipeline::ComputePipeline(const std::shared_ptr<VulkanContext>& context) :
+ComputePipeline::ComputePipeline(const std::shared_ptr<VulkanContext>& context, const uint32_t framesInFlight) :
     Pipeline(context),
     currentWidth(-1),
-    currentHeight(-1) {
+    currentHeight(-1),
+    frames(framesInFlight) {
     CreateDescriptorSetLayout();
     CreatePipelineLayout();
     CreatePipeline();
+
+    tileScheduler = std::make_unique<TileScheduler>(context, framesInFlight);
+    uploadProfiler = std::make_unique<GpuProfiler>(context, context->transferQueueIndex, 1);
 }
 
 void ComputePipeline::Update(const Raytracer& raytracer) {
-    if (raytracer.IsAnyDirty()) pushData.frameIndex = 0;
+    TRACE_SCOPE("ComputePipeline::Update");
+
+    // Display and scheduling settings leave the converged image as it is, their samples are kept
+    if (raytracer.IsDirty(DirtyFlags::Size) ||
+        raytracer.IsDirty(DirtyFlags::Camera) ||
+        (raytracer.IsDirty(DirtyFlags::Settings) && RestartsAccumulation(appliedSettings, raytracer.GetSettings()))) {
+        RestartAccumulation();
+    }
 
     if (raytracer.IsDirty(DirtyFlags::Size)) {
         currentWidth = raytracer.GetWidth();
         currentHeight = raytracer.GetHeight();
 
-        vulkanContext->device.waitIdle();
+        // Frames in flight may still sample the old image
+        if (outputImage) {
+            vulkanContext->Retire(std::move(outputImageView));
+            vulkanContext->Retire(std::move(outputImage));
+            vulkanContext->Retire(std::move(accumulationBuffer));
+            vulkanContext->Retire(std::move(pixelStats));
+            vulkanContext->Retire(std::move(tileMask));
+        }
 
         CreateResources();
-        CreateDescriptorSet();
-        ComputeGroupCount();
+        UpdateTraceSize();
+        bindingsVersion++;
+
+        // Once allocated, the wavefront state follows the image size
+        if (wavefront) {
+            vulkanContext->Retire(std::move(wavefront));
+            CreateWavefrontResources();
+        }
 
         raytracer.ClearDirty(DirtyFlags::Size);
     }
 
-    bool recreateDescriptorSet = false;
+    if (raytracer.IsDirty(DirtyFlags::Settings)) {
+        const RenderSettings& settings = raytracer.GetSettings();
+        integrator = settings.integrator;
+        if (settings.sortRays && !appliedSettings.sortRays && !sortSupported) {
+            LOGW("Ray sorting needs workgroups of {} invocations, rays are traced unsorted", SORT_GROUP_SIZE);
+        }
+        sortRays = settings.sortRays && sortSupported;
+        samplesPerDispatch = std::clamp(settings.samplesPerDispatch, 1u, MAX_SAMPLES_PER_DISPATCH);
+        budgetSamples = static_cast<float>(samplesPerDispatch);
+        pushData.maxBounces = std::clamp(settings.maxBounces, 1u, MAX_BOUNCES);
+        pushData.rouletteDepth = RouletteDepth(settings);
+        pushData.lightSampling = settings.lightSampling;
+        pushData.sampleSequence = static_cast<uint32_t>(settings.sampleSequence);
+        adaptiveSampling = settings.adaptiveSampling;
+        pushData.adaptiveThreshold = std::clamp(settings.adaptiveThreshold, 1e-4f, 1.0f);
+        pushData.adaptiveMinSamples = settings.adaptiveMinSamples;
+        // A cached image has to be resolved again to show another tone mapping
+        if (pushData.toneMapping != settings.toneMapping) resolvePending = true;
+        pushData.toneMapping = settings.toneMapping;
+        tileScheduler->SetOrder(settings.tileOrder);
+        appliedSettings = settings;
+
+        if (integrator == Integrator::Wavefront && !wavefront) CreateWavefrontResources();
+
+        raytracer.ClearDirty(DirtyFlags::Settings);
+    }
 
     if (raytracer.IsDirty(DirtyFlags::Camera)) {
-        cameraUBO->Update(raytracer.GetCamera().GetData());
+        cameraData = raytracer.GetCamera().GetData();
+        cameraVersion++;
         raytracer.ClearDirty(DirtyFlags::Camera);
     }
 
-    if (raytracer.IsDirty(DirtyFlags::SceneData)) {
-        sceneDataUBO->Update(raytracer.GetScene().GetSceneData());
-        raytracer.ClearDirty(DirtyFlags::SceneData);
+    if (uploader->Poll()) CommitScene();
+    UploadScene(raytracer);
+}
+
+uint32_t ComputePipeline::Dispatch(const vk::CommandBuffer commandBuffer, const uint32_t frame, const uint32_t maxSamples) {
+    // The caller waited for this frame's previous submission, its copies are free to rewrite
+    auto& frameResources = frames[frame];
+    UpdateFrameResources(frameResources);
+
+    // Acquire already check if a committed upload changed queue family
+    meshesSSBO->Acquire(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
+    trianglesSSBO->Acquire(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
+    bvhNodesSSBO->Acquire(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
+    spheresSSBO->Acquire(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
+    lightsSSBO->Acquire(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
+
+    // The accumulation, pixel stats and tile mask were last accessed by the previous frame, submitted earlier on
+    // this queue
+    constexpr vk::MemoryBarrier2 statsBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite,
+    };
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &statsBarrier});
+
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0,
+                                     frameResources.descriptorSet.get(), {});
+
+    pushData.adaptiveSampling = !adaptiveSampling ? ADAPTIVE_OFF : adaptiveMaskValid ? ADAPTIVE_MASK : ADAPTIVE_STATS;
+
+    uint32_t samples = std::min(samplesPerDispatch, maxSamples);
+    if (integrator == Integrator::Wavefront) {
+        // Each stage already covers every pixel, samples are chained in the same command buffer
+        pushData.samplesPerDispatch = 1;
+        for (uint32_t sample = 0; sample < samples; ++sample) {
+            DispatchWavefront(commandBuffer);
+            pushData.sampleIndex++;
+        }
+    } else if (IsTiled()) {
+        samples = DispatchTiles(commandBuffer, frameResources, frame, GetKernels(SelectVariant()).megakernel.get(),
+                                samples);
+    } else {
+        pushData.samplesPerDispatch = samples;
+        const KernelPipelines& kernels = GetKernels(SelectVariant());
+        if (integrator == Integrator::Persistent) {
+            DispatchPersistent(commandBuffer, kernels.persistent.get());
+        } else {
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, kernels.megakernel.get());
+            commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushData),
+                                        &pushData);
+            commandBuffer.dispatch(groupCountX, groupCountY, groupCountZ);
+        }
+        pushData.sampleIndex += samples;
     }
 
-    if (raytracer.IsDirty(DirtyFlags::Meshes)) {
-        meshesSSBO->Update(raytracer.GetScene().GetMeshes());
-        recreateDescriptorSet |= meshesSSBO->Changed();
-        raytracer.ClearDirty(DirtyFlags::Meshes);
+    // Whole-image dispatches rewrote every traced pixel, tiled ones cleared the accumulation first
+    accumulationStale = false;
+
+    // Tiled passes only update the mask once they covered the image
+    if (adaptiveSampling && samples > 0) {
+        pushData.samplesPerDispatch = samples;
+        DispatchAdaptiveMask(commandBuffer, frameResources);
+        adaptiveMaskValid = true;
     }
 
-    if (raytracer.IsDirty(DirtyFlags::Triangles)) {
-        trianglesSSBO->Update(raytracer.GetScene().GetTriangles());
-        recreateDescriptorSet |= trianglesSSBO->Changed();
-        raytracer.ClearDirty(DirtyFlags::Triangles);
+    return samples;
+}
+
+void ComputePipeline::Resolve(const vk::CommandBuffer commandBuffer, const uint32_t frame) {
+    UpdateFrameResources(frames[frame]);
+
+    constexpr vk::MemoryBarrier2 samplesBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderRead,
+    };
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &samplesBarrier});
+
+    TransitionForCompute(commandBuffer);
+
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0,
+                                     frames[frame].descriptorSet.get(), {});
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, resolvePipeline.get());
+    commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushData), &pushData);
+    commandBuffer.dispatch(groupCountX, groupCountY, 1);
+
+    TransitionForDisplay(commandBuffer);
+    resolvePending = false;
+}
+
+bool ComputePipeline::IsConverged(const uint32_t frame) const {
+    const FrameResources& resources = frames[frame];
+    if (!adaptiveSampling || resources.adaptiveAccumulation != accumulation) return false;
+
+    AdaptiveStats stats{};
+    resources.adaptiveStats->Read(stats);
+    return stats.activeTiles == 0;
+}
+
+double ComputePipeline::GetMeanPixelSamples(const uint32_t frame) const {
+    const FrameResources& resources = frames[frame];
+    if (!adaptiveSampling || resources.adaptiveAccumulation != accumulation) return 0.0;
+
+    AdaptiveStats stats{};
+    resources.adaptiveStats->Read(stats);
+    const uint64_t samples = static_cast<uint64_t>(stats.pixelSamplesHigh) << 32 | stats.pixelSamplesLow;
+    return static_cast<double>(samples) / (static_cast<double>(pushData.imageWidth) * pushData.imageHeight);
+}
+
+void ComputePipeline::SetRenderScale(const float scale) {
+    renderScale = std::clamp(scale, MIN_RENDER_SCALE, 1.0f);
+
+    // Pixels of the accumulation are laid out with the traced width: a new extent starts a new accumulation
+    if (UpdateTraceSize()) RestartAccumulation();
+}
+
+void ComputePipeline::FitRenderScale(const float budgetMs, const float computeMs) {
+    if (computeMs <= 0.0f) return;
+
+    // Tracing time follows the pixel count: the square root of the ratio is the ideal step of each side,
+    // its square root again damps the reaction to a measurement a few frames old
+    SetRenderScale(renderScale * std::clamp(std::pow(budgetMs / computeMs, 0.25f), 0.5f, 2.0f));
+}
+
+void ComputePipeline::FitSamplesToBudget(const float budgetMs, const float computeMs) {
+    if (computeMs <= 0.0f) return;
+
+    // The measured pass is a few frames old, damped steps keep the count from oscillating
+    const float scale = std::clamp(std::sqrt(budgetMs / computeMs), 0.5f, 2.0f);
+    budgetSamples = std::clamp(budgetSamples * scale, 1.0f, static_cast<float>(MAX_SAMPLES_PER_DISPATCH));
+    samplesPerDispatch = static_cast<uint32_t>(budgetSamples);
+}
+
+void ComputePipeline::DispatchWavefront(const vk::CommandBuffer cmd) {
+    // Every stage consumes the queues, counters and indirect arguments of the previous one. The first
+    // barrier also orders the counter clear after the previous frame, submitted earlier on this queue.
+    constexpr vk::MemoryBarrier2 stageBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eTransfer,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader |
+                        vk::PipelineStageFlagBits2::eDrawIndirect |
+                        vk::PipelineStageFlagBits2::eTransfer,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderRead |
+                         vk::AccessFlagBits2::eShaderWrite |
+                         vk::AccessFlagBits2::eIndirectCommandRead |
+                         vk::AccessFlagBits2::eTransferWrite,
+    };
+    const auto barrier = [&] {
+        cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &stageBarrier});
+    };
+
+    const auto bind = [&](const vk::UniquePipeline& stage) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eCompute, stage.get());
+        cmd.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushData), &pushData);
+    };
+
+    const vk::Buffer counters = wavefront->counters->GetHandle();
+    const auto argsOffset = [](const size_t member, const uint32_t bounce) {
+        return member + bounce * sizeof(DispatchArgs);
+    };
+
+    barrier();
+    cmd.fillBuffer(counters, 0, vk::WholeSize, 0);
+    barrier();
+
+    // Stable LSD radix sort of the (key, ray) pairs, 8 bits per pass
+    const auto sort = [&](const uint32_t bounce) {
+        const vk::DeviceSize sortArgs = argsOffset(offsetof(WavefrontCounters, sortArgs), bounce);
+
+        barrier();
+        bind(wavefrontPipelines.sortKeys);
+        cmd.dispatchIndirect(counters, sortArgs);
+
+        for (uint32_t pass = 0; pass < SORT_PASSES; ++pass) {
+            pushData.sortPass = pass;
+
+            barrier();
+            bind(wavefrontPipelines.sortHistogram);
+            cmd.dispatchIndirect(counters, sortArgs);
+
+            // Scans blocks of SORT_RADIX counts, one per sort block, then the sums of the blocks
+            barrier();
+            bind(wavefrontPipelines.sortScanBlocks);
+            cmd.dispatchIndirect(counters, sortArgs);
+
+            barrier();
+            bind(wavefrontPipelines.sortScan);
+            cmd.dispatch(1, 1, 1);
+
+            barrier();
+            bind(wavefrontPipelines.sortScatter);
+            cmd.dispatchIndirect(counters, sortArgs);
+        }
+    };
+
+    pushData.bounce = 0;
+    pushData.sortRays = 0;
+    bind(wavefrontPipelines.generate);
+    cmd.dispatch(groupCountX, groupCountY, groupCountZ);
+
+    for (uint32_t bounce = 0; bounce < pushData.maxBounces; ++bounce) {
+        pushData.bounce = bounce;
+
+        barrier();
+        bind(wavefrontPipelines.args);
+        cmd.dispatch(1, 1, 1);
+
+        // Primary rays leave the camera in pixel order, already coherent
+        pushData.sortRays = sortRays && bounce > 0;
+        if (pushData.sortRays) sort(bounce);
+
+        barrier();
+        bind(wavefrontPipelines.extend);
+        cmd.dispatchIndirect(counters, argsOffset(offsetof(WavefrontCounters, extendArgs), bounce));
+
+        barrier();
+        bind(wavefrontPipelines.args);
+        cmd.dispatch(1, 1, 1);
+
+        // Misses and hits end or continue different paths, the two stages may overlap
+        barrier();
+        bind(wavefrontPipelines.miss);
+        cmd.dispatchIndirect(counters, argsOffset(offsetof(WavefrontCounters, missArgs), bounce));
+        bind(wavefrontPipelines.shade);
+        cmd.dispatchIndirect(counters, argsOffset(offsetof(WavefrontCounters, shadeArgs), bounce));
+    }
+}
+
+void ComputePipeline::DispatchPersistent(const vk::CommandBuffer cmd, const vk::Pipeline persistent) const {
+    // The previous frame drained the queue before it is reset
+    constexpr vk::MemoryBarrier2 clearBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+    };
+    cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &clearBarrier});
+
+    cmd.fillBuffer(workQueue->GetHandle(), 0, vk::WholeSize, 0);
+
+    constexpr vk::MemoryBarrier2 queueBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite,
+    };
+    cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &queueBarrier});
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, persistent);
+    cmd.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushData), &pushData);
+    cmd.dispatch(persistentGroupCount, 1, 1);
+}
+
+uint32_t ComputePipeline::DispatchTiles(const vk::CommandBuffer cmd, FrameResources& frame, const uint32_t slot,
+                                       const vk::Pipeline megakernel, const uint32_t samples) {
+    static_assert(TileScheduler::TILE_SIZE % WORK_GROUP_SIZE_X == 0 &&
+                  TileScheduler::TILE_SIZE % WORK_GROUP_SIZE_Y == 0, "Tiles are made of whole workgroups");
+    constexpr uint32_t groupsPerTile = TileScheduler::TILE_SIZE / WORK_GROUP_SIZE_X *
+                                       (TileScheduler::TILE_SIZE / WORK_GROUP_SIZE_Y);
+
+    tileScheduler->BeginFrame(slot);
+
+    // Every pixel of a pass gets the samples chosen when it started
+    if (tileScheduler->IsPassStart()) passSamples = samples;
+
+    // The slot's previous submission is complete, its list is free to rewrite
+    const std::vector<uint32_t>& tiles = tileScheduler->NextTiles(slot);
+    frame.tileList->Update(tiles);
+
+    // Tiles not traced yet are resolved from the accumulation: after a restart or a new layout they would show the
+    // previous image, the first tiles of the new pass clear it
+    if (accumulationStale) {
+        constexpr vk::MemoryBarrier2 clearBarrier{
+            .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+            .srcAccessMask = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite,
+            .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+            .dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        };
+        cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &clearBarrier});
+
+        cmd.fillBuffer(accumulationBuffer->GetHandle(), 0, vk::WholeSize, 0);
+
+        constexpr vk::MemoryBarrier2 tracesBarrier{
+            .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+            .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+            .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+            .dstAccessMask = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite,
+        };
+        cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &tracesBarrier});
+        accumulationStale = false;
     }
 
-    if (raytracer.IsDirty(DirtyFlags::BVH_Nodes)) {
-        bvhNodesSSBO->Update(raytracer.GetScene().GetBVHNodes());
-        recreateDescriptorSet |= bvhNodesSSBO->Changed();
-        raytracer.ClearDirty(DirtyFlags::BVH_Nodes);
+    pushData.samplesPerDispatch = passSamples;
+    pushData.tileCount = static_cast<uint32_t>(tiles.size());
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, megakernel);
+    cmd.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushData), &pushData);
+    {
+        const GpuScope scope = tileScheduler->TimeTiles(cmd);
+        cmd.dispatch(groupsPerTile, pushData.tileCount, 1);
     }
+    pushData.tileCount = 0;
+
+    if (!tileScheduler->IsPassComplete()) return 0;
+
+    tileScheduler->Restart();
+    pushData.sampleIndex += passSamples;
+    return passSamples;
+}
+
+void ComputePipeline::DispatchAdaptiveMask(const vk::CommandBuffer cmd, FrameResources& frame) {
+    static_assert(WORK_GROUP_SIZE_X == ADAPTIVE_TILE_SIZE && WORK_GROUP_SIZE_Y == ADAPTIVE_TILE_SIZE,
+                  "The mask is dispatched with the megakernel group count, one group per tile");
+
+    // The slot's previous submission is complete, its counter is cleared from the host
+    frame.adaptiveStats->Update(AdaptiveStats{});
+    frame.adaptiveAccumulation = accumulation;
+
+    constexpr vk::MemoryBarrier2 samplesBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite,
+    };
+    cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &samplesBarrier});
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, adaptiveMaskPipeline.get());
+    cmd.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushData), &pushData);
+    cmd.dispatch(groupCountX, groupCountY, 1);
+
+    // IsConverged() reads the counter once the frame's timeline value is reached
+    constexpr vk::MemoryBarrier2 hostBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+        .dstAccessMask = vk::AccessFlagBits2::eHostRead,
+    };
+    cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &hostBarrier});
+}
 
-    if (raytracer.IsDirty(DirtyFlags::Spheres)) {
-        spheresSSBO->Update(raytracer.GetScene().GetSpheres());
-        recreateDescriptorSet |= spheresSSBO->Changed();
-        raytracer.ClearDirty(DirtyFlags::Spheres);
+void ComputePipeline::RestartAccumulation() {
+    pushData.sampleIndex = 0;
+    accumulation++;
+    accumulationStale = true;
+    adaptiveMaskValid = false;
+    tileScheduler->Restart();
+}
+
+KernelVariant ComputePipeline::SelectVariant() const {
+    // Deepest path of the push-both traversal: one entry per level, plus the sibling of the leaf
+    const uint32_t stackEntries = sceneData.bvhDepth + 1;
+    const uint32_t stackSize = (stackEntries + BVH_STACK_STEP - 1) / BVH_STACK_STEP * BVH_STACK_STEP;
+
+    // Features absent from the committed scene are compiled out
+    return {
+        .bounces = pushData.maxBounces,
+        .bvhStackSize = std::clamp(stackSize, BVH_STACK_STEP, MAX_BVH_STACK_SIZE),
+        .aaRatio = AA_RATIO,
+        .spheres = sceneData.numSpheres > 0,
+        .meshes = sceneData.numMeshes > 0,
+    };
+}
+
+const ComputePipeline::KernelPipelines& ComputePipeline::GetKernels(const KernelVariant& variant) {
+    if (const auto it = kernelVariants.find(variant); it != kernelVariants.end()) return it->second;
+
+    TRACE_SCOPE("ComputePipeline::BuildVariant");
+    const auto start = std::chrono::steady_clock::now();
+
+    if (sceneData.bvhDepth + 1 > MAX_BVH_STACK_SIZE) {
+        LOGW("BVH depth {} exceeds the traversal stack of {} entries", sceneData.bvhDepth, MAX_BVH_STACK_SIZE);
     }
 
-    if (recreateDescriptorSet) {
-        CreateDescriptorSet();
-        spheresSSBO->ResetChanged();
+    const auto entry = [](const uint32_t id, const size_t offset, const size_t size) {
+        return vk::SpecializationMapEntry{.constantID = id, .offset = static_cast<uint32_t>(offset), .size = size};
+    };
+    const std::array entries = {
+        entry(0, offsetof(KernelVariant, bounces), sizeof(uint32_t)),
+        entry(1, offsetof(KernelVariant, bvhStackSize), sizeof(uint32_t)),
+        entry(2, offsetof(KernelVariant, aaRatio), sizeof(float)),
+        entry(3, offsetof(KernelVariant, spheres), sizeof(vk::Bool32)),
+        entry(4, offsetof(KernelVariant, meshes), sizeof(vk::Bool32)),
+    };
+
+    const vk::SpecializationInfo specialization{
+        .mapEntryCount = static_cast<uint32_t>(entries.size()),
+        .pMapEntries = entries.data(),
+        .dataSize = sizeof(KernelVariant),
+        .pData = &variant,
+    };
+
+    KernelPipelines kernels{
+        .megakernel = CreateComputePipeline("../shaders/main.comp.spv", &specialization),
+        .persistent = CreateComputePipeline("../shaders/persistent.comp.spv", &specialization),
+    };
+
+    LOGI("Built kernels for {} bounces, stack {}, spheres {}, meshes {} in {:.1f} ms",
+         variant.bounces, variant.bvhStackSize, variant.spheres ? "on" : "off", variant.meshes ? "on" : "off",
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    return kernelVariants.emplace(variant, std::move(kernels)).first->second;
+}
+
+void ComputePipeline::UploadScene(const Raytracer& raytracer) {
+    // Only one batch in flight: later edits stay dirty until the current one is committed
+    if (uploader->IsBusy()) return;
+
+    // The back buffers were bound to frames submitted before the last commit
+    if (!vulkanContext->graphicsTimeline->IsComplete(backBuffersFreeAt)) return;
+
+    const bool meshes = raytracer.IsDirty(DirtyFlags::Meshes);
+    const bool triangles = raytracer.IsDirty(DirtyFlags::Triangles);
+    const bool bvhNodes = raytracer.IsDirty(DirtyFlags::BVH_Nodes);
+    const bool spheres = raytracer.IsDirty(DirtyFlags::Spheres);
+    if (!raytracer.IsDirty(DirtyFlags::SceneData) && !meshes && !triangles && !bvhNodes && !spheres) return;
+
+    TRACE_SCOPE("ComputePipeline::UploadScene");
+
+    const auto stage = [this](StorageBuffer& ssbo, const auto& data) {
+        ssbo.Update(data);
+        uploadedBytes += std::span(data).size_bytes();
+    };
+
+    const auto& scene = raytracer.GetScene();
+    if (meshes) stage(*meshesSSBO, scene.GetMeshes());
+    if (triangles) stage(*trianglesSSBO, scene.GetTriangles());
+    if (bvhNodes) stage(*bvhNodesSSBO, scene.GetBVHNodes());
+    if (spheres) stage(*spheresSSBO, scene.GetSpheres());
+
+    // Counts must match the buffers, so they are only published on commit
+    pendingSceneData = scene.GetSceneData();
+
+    // Any of the above can add, move or dim a light: the list is small enough to be restaged with every batch
+    stage(*lightsSSBO, scene.GetLights());
+
+    // The previous batch is committed, its timestamps are available
+    uploadProfiler->BeginFrame(0);
+
+    const vk::CommandBuffer cmd = uploader->Begin();
+    {
+        GpuScope scope(*uploadProfiler, cmd, "Upload");
+        meshesSSBO->Upload(cmd);
+        trianglesSSBO->Upload(cmd);
+        bvhNodesSSBO->Upload(cmd);
+        spheresSSBO->Upload(cmd);
+        lightsSSBO->Upload(cmd);
     }
+    uploader->Submit();
 
-    pushData.frameIndex++;
+    raytracer.ClearDirty(DirtyFlags::SceneData);
+    raytracer.ClearDirty(DirtyFlags::Meshes);
+    raytracer.ClearDirty(DirtyFlags::Triangles);
+    raytracer.ClearDirty(DirtyFlags::BVH_Nodes);
+    raytracer.ClearDirty(DirtyFlags::Spheres);
 }
 
-void ComputePipeline::Dispatch(const vk::CommandBuffer commandBuffer) const {
-    TransitionForCompute(commandBuffer);
+void ComputePipeline::CommitScene() {
+    uploadProfiler->Collect();
 
-    // Upload already check if its needed
-    meshesSSBO->Upload(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
-    trianglesSSBO->Upload(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
-    bvhNodesSSBO->Upload(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
-    spheresSSBO->Upload(commandBuffer, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderRead);
+    meshesSSBO->Commit();
+    trianglesSSBO->Commit();
+    bvhNodesSSBO->Commit();
+    spheresSSBO->Commit();
+    lightsSSBO->Commit();
 
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
-    commandBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushData), &pushData);
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, descriptorSet.get(), {});
-    commandBuffer.dispatch(groupCountX, groupCountY, groupCountZ);
+    sceneData = pendingSceneData;
+    sceneVersion++;
+    bindingsVersion++;
 
-    TransitionForDisplay(commandBuffer);
+    // Every frame slot rewrites its descriptor set before its next dispatch
+    backBuffersFreeAt = vulkanContext->graphicsTimeline->LastSubmitted();
+
+    RestartAccumulation();
+}
+
+void ComputePipeline::WaitForSceneUpload() {
+    uploader->Wait();
+    if (uploader->Poll()) CommitScene();
+}
+
+void ComputePipeline::RecordReadback(const vk::CommandBuffer commandBuffer, const Buffer& destination) const {
+    constexpr vk::MemoryBarrier2 copyBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferRead,
+    };
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &copyBarrier});
+
+    const vk::BufferCopy region{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = accumulationBuffer->GetSize(),
+    };
+    commandBuffer.copyBuffer(accumulationBuffer->GetHandle(), destination.GetHandle(), region);
+
+    // Both the copy and the ray counters are read by the host
+    const vk::MemoryBarrier2 hostBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+        .dstAccessMask = vk::AccessFlagBits2::eHostRead,
+    };
+    commandBuffer.pipelineBarrier2(vk::DependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &hostBarrier,
+    });
+}
+
+uint64_t ComputePipeline::GetRayCount() const {
+    RayStats stats{};
+    rayStatsBuffer->Read(stats);
+    return static_cast<uint64_t>(stats.rayCountHigh) << 32 | stats.rayCountLow;
+}
+
+void ComputePipeline::ResetRayStats() const {
+    rayStatsBuffer->Update(RayStats{});
 }
 
 void ComputePipeline::CreateDescriptorSetLayout() {
     constexpr auto stage = vk::ShaderStageFlagBits::eCompute;
     DescriptorSetLayoutBuilder layoutBuilder;
-    layoutBuilder.AddBinding(0, vk::DescriptorType::eStorageImage, stage)
+    layoutBuilder.AddBinding(0, vk::DescriptorType::eStorageBuffer, stage)
                  .AddBinding(1, vk::DescriptorType::eUniformBuffer, stage)
                  .AddBinding(2, vk::DescriptorType::eUniformBuffer, stage)
                  .AddBinding(3, vk::DescriptorType::eStorageBuffer, stage)
                  .AddBinding(4, vk::DescriptorType::eStorageBuffer, stage)
                  .AddBinding(5, vk::DescriptorType::eStorageBuffer, stage)
                  .AddBinding(6, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(7, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(8, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(9, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(10, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(11, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(12, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(13, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(14, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(15, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(16, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(17, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(18, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(19, vk::DescriptorType::eStorageBuffer, stage)
+                 .AddBinding(20, vk::DescriptorType::eStorageImage, stage)
+                 .AddBinding(21, vk::DescriptorType::eStorageBuffer, stage)
                  .AddTo(vulkanContext->device, descriptorSetLayouts);
 }
 
-void ComputePipeline::CreateDescriptorSet() {
-    descriptorSet = std::move(AllocateDescriptorSets()[0]);
-
+void ComputePipeline::WriteDescriptorSet(const FrameResources& frame) const {
     DescriptorSetWriter writer;
-    writer.WriteStorageImage(0, outputImageView.get())
-          .WriteBuffer(1, cameraUBO->GetHandle(), cameraUBO->GetSize())
-          .WriteBuffer(2, sceneDataUBO->GetHandle(), sceneDataUBO->GetSize())
+    writer.WriteBuffer(0, accumulationBuffer->GetHandle(), accumulationBuffer->GetSize(),
+                       vk::DescriptorType::eStorageBuffer)
+          .WriteBuffer(1, frame.cameraUBO->GetHandle(), frame.cameraUBO->GetSize())
+          .WriteBuffer(2, frame.sceneDataUBO->GetHandle(), frame.sceneDataUBO->GetSize())
           .WriteBuffer(3, meshesSSBO->GetHandle(), meshesSSBO->GetSize(), vk::DescriptorType::eStorageBuffer)
           .WriteBuffer(4, trianglesSSBO->GetHandle(), trianglesSSBO->GetSize(), vk::DescriptorType::eStorageBuffer)
           .WriteBuffer(5, bvhNodesSSBO->GetHandle(), bvhNodesSSBO->GetSize(), vk::DescriptorType::eStorageBuffer)
           .WriteBuffer(6, spheresSSBO->GetHandle(), spheresSSBO->GetSize(), vk::DescriptorType::eStorageBuffer)
-          .Update(vulkanContext->device, descriptorSet.get());
+          .WriteBuffer(7, rayStatsBuffer->GetHandle(), rayStatsBuffer->GetSize(), vk::DescriptorType::eStorageBuffer)
+          .WriteBuffer(13, workQueue->GetHandle(), workQueue->GetSize(), vk::DescriptorType::eStorageBuffer)
+          .WriteBuffer(16, lightsSSBO->GetHandle(), lightsSSBO->GetSize(), vk::DescriptorType::eStorageBuffer)
+          .WriteBuffer(17, pixelStats->GetHandle(), pixelStats->GetSize(), vk::DescriptorType::eStorageBuffer)
+          .WriteBuffer(18, tileMask->GetHandle(), tileMask->GetSize(), vk::DescriptorType::eStorageBuffer)
+          .WriteBuffer(19, frame.adaptiveStats->GetHandle(), frame.adaptiveStats->GetSize(),
+                       vk::DescriptorType::eStorageBuffer)
+          .WriteStorageImage(20, outputImageView.get())
+          .WriteBuffer(21, frame.tileList->GetHandle(), frame.tileList->GetSize(), vk::DescriptorType::eStorageBuffer);
+
+    // Only the wavefront kernels use bindings 8-12 and 14-15, the other kernels leave them unwritten
+    if (wavefront) {
+        constexpr auto storage = vk::DescriptorType::eStorageBuffer;
+        writer.WriteBuffer(8, wavefront->paths->GetHandle(), wavefront->paths->GetSize(), storage)
+              .WriteBuffer(9, wavefront->rayQueues->GetHandle(), wavefront->rayQueues->GetSize(), storage)
+              .WriteBuffer(10, wavefront->hitQueue->GetHandle(), wavefront->hitQueue->GetSize(), storage)
+              .WriteBuffer(11, wavefront->missQueue->GetHandle(), wavefront->missQueue->GetSize(), storage)
+              .WriteBuffer(12, wavefront->counters->GetHandle(), wavefront->counters->GetSize(), storage)
+              .WriteBuffer(14, wavefront->sortPairs->GetHandle(), wavefront->sortPairs->GetSize(), storage)
+              .WriteBuffer(15, wavefront->sortHistograms->GetHandle(), wavefront->sortHistograms->GetSize(), storage);
+    }
+
+    writer.Update(vulkanContext->device, frame.descriptorSet.get());
+}
+
+void ComputePipeline::UpdateFrameResources(FrameResources& frame) const {
+    if (frame.cameraVersion != cameraVersion) {
+        frame.cameraUBO->Update(cameraData);
+        frame.cameraVersion = cameraVersion;
+    }
+
+    if (frame.sceneVersion != sceneVersion) {
+        frame.sceneDataUBO->Update(sceneData);
+        frame.sceneVersion = sceneVersion;
+    }
+
+    if (frame.bindingsVersion != bindingsVersion) {
+        WriteDescriptorSet(frame);
+        frame.bindingsVersion = bindingsVersion;
+    }
 }
 
 void ComputePipeline::CreatePipeline() {
-    vk::UniqueShaderModule shaderModule = vkHelpers::CreateShaderModule(
-        vulkanContext->device, "../shaders/main.comp.spv");
+    // The megakernels are specialized per scene, see GetKernels()
+    wavefrontPipelines = {
+        .generate = CreateComputePipeline("../shaders/wavefront_generate.comp.spv"),
+        .args = CreateComputePipeline("../shaders/wavefront_args.comp.spv"),
+        .extend = CreateComputePipeline("../shaders/wavefront_extend.comp.spv"),
+        .shade = CreateComputePipeline("../shaders/wavefront_shade.comp.spv"),
+        .miss = CreateComputePipeline("../shaders/wavefront_miss.comp.spv"),
+    };
+
+    // Every sort kernel runs SORT_GROUP_SIZE invocations, above the minimum the specification guarantees
+    const vk::PhysicalDeviceLimits& limits = vulkanContext->physicalDevice.getProperties().limits;
+    sortSupported = limits.maxComputeWorkGroupInvocations >= SORT_GROUP_SIZE &&
+                    limits.maxComputeWorkGroupSize[0] >= SORT_GROUP_SIZE;
+    if (sortSupported) {
+        wavefrontPipelines.sortKeys = CreateComputePipeline("../shaders/sort_keys.comp.spv");
+        wavefrontPipelines.sortHistogram = CreateComputePipeline("../shaders/sort_histogram.comp.spv");
+        wavefrontPipelines.sortScanBlocks = CreateComputePipeline("../shaders/sort_scan_blocks.comp.spv");
+        wavefrontPipelines.sortScan = CreateComputePipeline("../shaders/sort_scan.comp.spv");
+        wavefrontPipelines.sortScatter = CreateComputePipeline("../shaders/sort_scatter.comp.spv");
+    }
+    adaptiveMaskPipeline = CreateComputePipeline("../shaders/adaptive_mask.comp.spv");
+    resolvePipeline = CreateComputePipeline("../shaders/resolve.comp.spv");
+}
+
+vk::UniquePipeline ComputePipeline::CreateComputePipeline(const std::filesystem::path& shaderPath,
+                                                          const vk::SpecializationInfo* specialization) const {
+    vk::UniqueShaderModule shaderModule = vkHelpers::CreateShaderModule(vulkanContext->device, shaderPath);
 
     const vk::PipelineShaderStageCreateInfo shaderStageInfo{
         .stage = vk::ShaderStageFlagBits::eCompute,
         .module = shaderModule.get(),
         .pName = "main",
+        .pSpecializationInfo = specialization,
     };
 
     const vk::ComputePipelineCreateInfo pipelineInfo{
@@ -130,7 +734,9 @@ void ComputePipeline::CreatePipeline() {
         .layout = pipelineLayout,
     };
 
-    pipeline = vulkanContext->device.createComputePipeline({}, pipelineInfo).value;
+    auto result = vulkanContext->device.createComputePipelineUnique(vulkanContext->pipelineCache, pipelineInfo);
+    vulkanContext->TrackCreation();
+    return std::move(result.value);
 }
 
 void ComputePipeline::CreatePipelineLayout() {
@@ -151,30 +757,69 @@ void ComputePipeline::CreatePipelineLayout() {
 }
 
 void ComputePipeline::CreateResources() {
+    constexpr auto storage = vk::BufferUsageFlagBits::eStorageBuffer;
+    constexpr auto deviceLocal = vk::MemoryPropertyFlagBits::eDeviceLocal;
+    const vk::DeviceSize pixelCount = static_cast<vk::DeviceSize>(currentWidth) * currentHeight;
+
+    // ---- Binding 0 : Running mean of every pixel, packed RGB, copied as is by readbacks ---- //
+    accumulationBuffer = std::make_unique<Buffer>(vulkanContext,
+                                                  3 * sizeof(float) * pixelCount,
+                                                  storage |
+                                                  vk::BufferUsageFlagBits::eTransferSrc |
+                                                  vk::BufferUsageFlagBits::eTransferDst,
+                                                  deviceLocal);
+    accumulationStale = true;
+
+    // ---- Binding 20 : Display image, a quarter of the bytes of the accumulation for the graphics pass ---- //
     outputImage = std::make_unique<Image>(vulkanContext,
                                           currentWidth,
                                           currentHeight,
-                                          vk::Format::eR32G32B32A32Sfloat,
+                                          vk::Format::eR8G8B8A8Unorm,
                                           vk::ImageUsageFlagBits::eStorage |
-                                          vk::ImageUsageFlagBits::eSampled |
-                                          vk::ImageUsageFlagBits::eTransferSrc);
+                                          vk::ImageUsageFlagBits::eSampled);
 
     outputImageView = outputImage->CreateView();
-
+    outputImageLayout = vk::ImageLayout::eUndefined;
+
+    // ---- Binding 17 : Luminance moment and sample count of every pixel ---- //
+    pixelStats = std::make_unique<Buffer>(vulkanContext, sizeof(PixelStats) * pixelCount, storage, deviceLocal);
+
+    // ---- Binding 18 : Samples of every tile in the next dispatch, written by the adaptive mask pass ---- //
+    const uint32_t tilesX = (currentWidth + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+    const uint32_t tilesY = (currentHeight + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+    const vk::DeviceSize tileCount = static_cast<vk::DeviceSize>(tilesX) * tilesY;
+    tileMask = std::make_unique<Buffer>(vulkanContext, sizeof(uint32_t) * tileCount, storage, deviceLocal);
+
+    // ---- Binding 21 : Scheduler tiles of each frame, as many as the image holds ---- //
+    const uint32_t scheduledX = (currentWidth + TileScheduler::TILE_SIZE - 1) / TileScheduler::TILE_SIZE;
+    const uint32_t scheduledY = (currentHeight + TileScheduler::TILE_SIZE - 1) / TileScheduler::TILE_SIZE;
+    for (auto& frame : frames) {
+        if (frame.tileList) vulkanContext->Retire(std::move(frame.tileList));
+        frame.tileList = std::make_unique<Buffer>(vulkanContext, sizeof(uint32_t) * scheduledX * scheduledY, storage);
+    }
 
     // This function is called every time the window is resized.
     // Only size-dependent resources (e.g. outputImage) need to be recreated on each call.
     // Other resources (camera, scene, etc.) only need to be created once.
     // If they already exist, we can return early.
-    if (cameraUBO) return;
+    if (uploader) return;
 
     constexpr auto uniformBufferFlag = vk::BufferUsageFlagBits::eUniformBuffer;
 
-    // ---- Binding 1 : Camera uniform buffer ---- //
-    cameraUBO = std::make_unique<Buffer>(vulkanContext, sizeof(CameraData), uniformBufferFlag);
+    for (auto& frame : frames) {
+        // ---- Binding 1 : Camera uniform buffer ---- //
+        frame.cameraUBO = std::make_unique<Buffer>(vulkanContext, sizeof(CameraData), uniformBufferFlag);
+
+        // ---- Binding 2 : SceneData uniform buffer ---- //
+        // Host-visible copy of the committed scene data, rewritten by each frame slot once the scene version moved.
+        // The counts stay at zero until the first upload is committed, frames render the sky until then.
+        frame.sceneDataUBO = std::make_unique<Buffer>(vulkanContext, sizeof(SceneData), uniformBufferFlag);
+
+        // ---- Binding 19 : Active tiles counted by the adaptive mask pass, read back by the host ---- //
+        frame.adaptiveStats = std::make_unique<Buffer>(vulkanContext, AdaptiveStats{}, storage);
 
-    // ---- Binding 2 : SceneData uniform buffer ---- //
-    sceneDataUBO = std::make_unique<Buffer>(vulkanContext, sizeof(SceneData), uniformBufferFlag);
+        frame.descriptorSet = std::move(AllocateDescriptorSets()[0]);
+    }
 
     // ---- Binding 3 : Meshes uniform buffer ---- //
     constexpr vk::DeviceSize meshesBufferSize = sizeof(Mesh) * 10;
@@ -191,18 +836,100 @@ void ComputePipeline::CreateResources() {
     // ---- Binding 6 : Spheres uniform buffer ---- //
     constexpr vk::DeviceSize spheresBufferSize = sizeof(Sphere) * 10;
     spheresSSBO = std::make_unique<StorageBuffer>(vulkanContext, spheresBufferSize);
+
+    // ---- Binding 7 : Ray counters, read back by the host ---- //
+    rayStatsBuffer = std::make_unique<Buffer>(vulkanContext, RayStats{}, vk::BufferUsageFlagBits::eStorageBuffer);
+
+    // ---- Binding 13 : Work queue of the persistent kernel, cleared every frame ---- //
+    workQueue = std::make_unique<Buffer>(vulkanContext,
+                                         sizeof(uint32_t),
+                                         vk::BufferUsageFlagBits::eStorageBuffer |
+                                         vk::BufferUsageFlagBits::eTransferDst,
+                                         vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+    // ---- Binding 16 : Emissive spheres and triangles, restaged with every scene upload ---- //
+    constexpr vk::DeviceSize lightsBufferSize = sizeof(Light) * 16;
+    lightsSSBO = std::make_unique<StorageBuffer>(vulkanContext, lightsBufferSize);
+
+    uploader = std::make_unique<Uploader>(vulkanContext);
+}
+
+void ComputePipeline::CreateWavefrontResources() {
+    const vk::DeviceSize pathCount = static_cast<vk::DeviceSize>(currentWidth) * currentHeight;
+    constexpr auto storage = vk::BufferUsageFlagBits::eStorageBuffer;
+    constexpr auto deviceLocal = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+    wavefront = std::make_unique<WavefrontResources>();
+
+    // ---- Binding 8 : Throughput, radiance and random state of every path ---- //
+    wavefront->paths = std::make_unique<Buffer>(vulkanContext, sizeof(PathState) * pathCount, storage, deviceLocal);
+
+    // ---- Binding 9 : Ray queues, the current bounce and the next one ---- //
+    wavefront->rayQueues = std::make_unique<Buffer>(vulkanContext, sizeof(QueuedRay) * pathCount * 2, storage,
+                                                    deviceLocal);
+
+    // ---- Binding 10-11 : Extend outputs ---- //
+    wavefront->hitQueue = std::make_unique<Buffer>(vulkanContext, sizeof(QueuedHit) * pathCount, storage, deviceLocal);
+    wavefront->missQueue = std::make_unique<Buffer>(vulkanContext, sizeof(uint32_t) * pathCount, storage, deviceLocal);
+
+    // ---- Binding 12 : Queue counters, cleared every frame ---- //
+    wavefront->counters = std::make_unique<Buffer>(vulkanContext,
+                                                   sizeof(WavefrontCounters),
+                                                   storage |
+                                                   vk::BufferUsageFlagBits::eIndirectBuffer |
+                                                   vk::BufferUsageFlagBits::eTransferDst,
+                                                   deviceLocal);
+
+    // ---- Binding 14 : Sort keys and ray indices, twice for the passes to alternate ---- //
+    wavefront->sortPairs = std::make_unique<Buffer>(vulkanContext, 2 * sizeof(uint32_t) * pathCount * 2, storage,
+                                                    deviceLocal);
+
+    // ---- Binding 15 : Digit counts of every sort block, then the sums of their scan blocks ---- //
+    const vk::DeviceSize sortBlocks = (pathCount + SORT_GROUP_SIZE - 1) / SORT_GROUP_SIZE;
+    wavefront->sortHistograms = std::make_unique<Buffer>(vulkanContext,
+                                                         sizeof(uint32_t) * (SORT_RADIX + 1) * sortBlocks,
+                                                         storage, deviceLocal);
+
+    bindingsVersion++;
+}
+
+bool ComputePipeline::UpdateTraceSize() {
+    const auto scaled = [this](const uint32_t size) {
+        return std::clamp(static_cast<uint32_t>(std::lround(static_cast<float>(size) * renderScale)), 1u, size);
+    };
+    const uint32_t width = scaled(currentWidth);
+    const uint32_t height = scaled(currentHeight);
+    if (width == pushData.imageWidth && height == pushData.imageHeight) return false;
+
+    pushData.imageWidth = width;
+    pushData.imageHeight = height;
+    ComputeGroupCount();
+    tileScheduler->Resize(width, height);
+    accumulationStale = true;
+    return true;
 }
 
 void ComputePipeline::ComputeGroupCount() {
-    groupCountX = (currentWidth + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X;
-    groupCountY = (currentHeight + WORK_GROUP_SIZE_Y - 1) / WORK_GROUP_SIZE_Y;
+    // Sized for the traced extent, the resources keep the size of the image
+    const uint32_t width = pushData.imageWidth;
+    const uint32_t height = pushData.imageHeight;
+    groupCountX = (width + WORK_GROUP_SIZE_X - 1) / WORK_GROUP_SIZE_X;
+    groupCountY = (height + WORK_GROUP_SIZE_Y - 1) / WORK_GROUP_SIZE_Y;
+
+    // Sized for the device rather than the image, but never more threads than pixels
+    const uint32_t units = vulkanContext->computeUnitCount;
+    const uint32_t resident = units != 0 ? units * PERSISTENT_GROUPS_PER_UNIT : PERSISTENT_FALLBACK_GROUPS;
+    const uint32_t pixelGroups = (width * height + PERSISTENT_GROUP_SIZE - 1) / PERSISTENT_GROUP_SIZE;
+    persistentGroupCount = std::min(resident, pixelGroups);
 }
 
 void ComputePipeline::TransitionForCompute(const vk::CommandBuffer cmd) const {
+    // The resolve overwrites every pixel, the content is discarded once previous frames stopped sampling it
+    const bool fresh = outputImageLayout == vk::ImageLayout::eUndefined;
     outputImage->TransitionLayout(cmd,
                                   vk::ImageLayout::eUndefined,
                                   vk::ImageLayout::eGeneral,
-                                  vk::PipelineStageFlagBits2::eTopOfPipe,
+                                  fresh ? vk::PipelineStageFlagBits2::eTopOfPipe : vk::PipelineStageFlagBits2::eFragmentShader,
                                   vk::PipelineStageFlagBits2::eComputeShader);
 }
 
@@ -212,5 +939,5 @@ void ComputePipeline::TransitionForDisplay(const vk::CommandBuffer cmd) const {
                                   vk::ImageLayout::eShaderReadOnlyOptimal,
                                   vk::PipelineStageFlagBits2::eComputeShader,
                                   vk::PipelineStageFlagBits2::eFragmentShader);
+    outputImageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
 }
-
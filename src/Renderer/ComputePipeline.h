@@ -1,35 +1,171 @@
 #pragma once
 
+#include <map>
+
 #include "Raytracer/Raytracer.h"
+#include "Renderer/TileScheduler.h"
 #include "Vulkan/Base.h"
 #include "Vulkan/Image.h"
 #include "Vulkan/Buffer.h"
+#include "Vulkan/GpuProfiler.h"
 #include "Vulkan/Pipeline.h"
+#include "Vulkan/Uploader.h"
 #include "Vulkan/VulkanContext.h"
 
 struct PushData {
-    uint32_t frameIndex;
+    uint32_t sampleIndex;        // Samples accumulated before this dispatch, 0 restarts the accumulation
+    uint32_t samplesPerDispatch;
+    uint32_t maxBounces;
+    uint32_t bounce;   // Wavefront stage being dispatched
+    uint32_t sortRays; // Extend reads its queue in sorted order
+    uint32_t sortPass; // Radix sort pass being dispatched
+    uint32_t rouletteDepth; // Bounces before Russian roulette starts, 0 disables it
+    uint32_t lightSampling; // Next-event estimation on diffuse hits
+    uint32_t sampleSequence;
+    uint32_t adaptiveSampling; // ADAPTIVE_MASK only once the mask was built for the current accumulation
+    float adaptiveThreshold;
+    uint32_t adaptiveMinSamples;
+    uint32_t imageWidth;
+    uint32_t imageHeight;
+    uint32_t toneMapping;
+    uint32_t tileCount; // Megakernel only, tiles listed for this dispatch, 0 dispatches the whole image
+};
+
+// Compile-time configuration of the megakernels, baked in as specialization constants (see common.glsl)
+struct KernelVariant {
+    uint32_t bounces = 0; // 0 reads maxBounces from the push constants
+    uint32_t bvhStackSize = 32;
+    float aaRatio = 1e-3f;
+    vk::Bool32 spheres = true;
+    vk::Bool32 meshes = true;
+
+    auto operator<=>(const KernelVariant&) const = default;
 };
 
 class ComputePipeline final : public Pipeline {
 public:
-    explicit ComputePipeline(const std::shared_ptr<VulkanContext>& context);
+    ComputePipeline(const std::shared_ptr<VulkanContext>& context, uint32_t framesInFlight);
     ~ComputePipeline() override = default;
 
     void Update(const Raytracer& raytracer);
-    void Dispatch(vk::CommandBuffer commandBuffer) const;
+    // Records up to maxSamples samples per pixel, returns how many. Tiled dispatches return 0 until the pass
+    // is complete.
+    uint32_t Dispatch(vk::CommandBuffer commandBuffer, uint32_t frame, uint32_t maxSamples = UINT32_MAX);
+
+    // Converts the accumulation into the display image, after the dispatches of a frame that presents it
+    void Resolve(vk::CommandBuffer commandBuffer, uint32_t frame);
+    // The display image is out of date even without new samples, after a display setting changed
+    bool IsResolvePending() const { return resolvePending; }
+
+    // Adaptive sampling only: every tile was under the threshold when this frame slot last ran.
+    // The caller waited for the slot's previous submission.
+    bool IsConverged(uint32_t frame) const;
+    // Adaptive sampling only: mean samples of the traced pixels when this frame slot's last submission completed,
+    // 0 if it did not build the mask of the current accumulation
+    double GetMeanPixelSamples(uint32_t frame) const;
+
+    // Scales the samples of the next dispatches towards the budget, from the time of a previous compute pass
+    void FitSamplesToBudget(float budgetMs, float computeMs);
+
+    // Traces a fraction of the image on each side, in its top-left corner. The resources keep the image size,
+    // a new traced extent only restarts the accumulation.
+    void SetRenderScale(float scale);
+    // Scales the traced extent towards the budget, from the time of a previous compute pass
+    void FitRenderScale(float budgetMs, float computeMs);
+
+    // Discards the samples accumulated so far, the next dispatch starts a new image
+    void RestartAccumulation();
+
+    // Megakernel passes are split into tiles that fit the budget, dispatches complete a pass once every
+    // tile was traced. 0 dispatches whole passes.
+    void SetTileBudget(const float ms) { tileScheduler->SetBudget(ms); }
+    // A pass started with tiles ends with them, its other pixels would be traced twice by a full dispatch
+    bool IsTiled() const {
+        return integrator == Integrator::Megakernel && (tileScheduler->IsEnabled() || !tileScheduler->IsPassStart());
+    }
+    const TileScheduler& GetTileScheduler() const { return *tileScheduler; }
+
+    // Transfer timeline value of the last committed scene upload, to be waited on by the next submission
+    uint64_t ConsumeUploadWait() const { return uploader->ConsumeWaitValue(); }
+
+    // Blocks until the scene upload in flight, if any, is committed
+    void WaitForSceneUpload();
+    bool IsUploading() const { return uploader->IsBusy(); }
+
+    // Copies the accumulation, packed RGB32F rows, into a host-visible buffer
+    void RecordReadback(vk::CommandBuffer commandBuffer, const Buffer& destination) const;
+
+    // Rays traced since the last reset, only valid once the dispatches that counted them have completed
+    uint64_t GetRayCount() const;
+    void ResetRayStats() const;
+
+    // Bytes staged for scene storage buffers since creation
+    uint64_t GetUploadedBytes() const { return uploadedBytes; }
+
+    // Upload batches are timed on the transfer queue
+    const GpuProfiler& GetUploadProfiler() const { return *uploadProfiler; }
+    void ResetUploadStats() const { uploadProfiler->ResetStats(); }
+
+    Integrator GetIntegrator() const { return integrator; }
+    uint32_t GetPersistentGroupCount() const { return persistentGroupCount; }
 
     vk::ImageView GetImageView() const { return outputImageView.get(); }
-    uint32_t GetFrameIndex() const { return pushData.frameIndex; }
+    uint32_t GetSampleCount() const { return pushData.sampleIndex; }
+    uint32_t GetSamplesPerDispatch() const { return samplesPerDispatch; }
+    uint32_t GetWidth() const { return currentWidth; }
+    uint32_t GetHeight() const { return currentHeight; }
+    float GetRenderScale() const { return renderScale; }
+    uint32_t GetTraceWidth() const { return pushData.imageWidth; }
+    uint32_t GetTraceHeight() const { return pushData.imageHeight; }
 
 private:
+    // Per frame-in-flight copies of everything the CPU writes while other frames may still run
+    struct FrameResources {
+        std::unique_ptr<Buffer> cameraUBO;    // Binding 1
+        std::unique_ptr<Buffer> sceneDataUBO; // Binding 2
+        std::unique_ptr<Buffer> adaptiveStats; // Binding 19, host-visible
+        std::unique_ptr<Buffer> tileList;      // Binding 21, host-visible, follows the image size
+        vk::UniqueDescriptorSet descriptorSet;
+
+        // Accumulation the adaptive stats were counted for, stale ones never report convergence
+        uint64_t adaptiveAccumulation = 0;
+
+        // Compared against the pipeline versions to only rewrite what changed
+        uint64_t cameraVersion = 0;
+        uint64_t sceneVersion = 0;
+        uint64_t bindingsVersion = 0;
+    };
+
     void CreateDescriptorSetLayout();
-    void CreateDescriptorSet();
+    void WriteDescriptorSet(const FrameResources& frame) const;
+    void UpdateFrameResources(FrameResources& frame) const;
     void CreatePipeline();
+    vk::UniquePipeline CreateComputePipeline(const std::filesystem::path& shaderPath,
+                                             const vk::SpecializationInfo* specialization = nullptr) const;
     void CreatePipelineLayout() override;
     void CreateResources();
+    void CreateWavefrontResources();
+    bool UpdateTraceSize(); // Returns true when the traced extent changed
     void ComputeGroupCount();
 
+    void DispatchWavefront(vk::CommandBuffer cmd);
+    void DispatchPersistent(vk::CommandBuffer cmd, vk::Pipeline persistent) const;
+    uint32_t DispatchTiles(vk::CommandBuffer cmd, FrameResources& frame, uint32_t slot, vk::Pipeline megakernel,
+                           uint32_t samples);
+    void DispatchAdaptiveMask(vk::CommandBuffer cmd, FrameResources& frame);
+
+    // Megakernels specialized for the committed scene and settings, built on first use
+    struct KernelPipelines {
+        vk::UniquePipeline megakernel;
+        vk::UniquePipeline persistent;
+    };
+
+    KernelVariant SelectVariant() const;
+    const KernelPipelines& GetKernels(const KernelVariant& variant);
+
+    void UploadScene(const Raytracer& raytracer);
+    void CommitScene();
+
     void TransitionForCompute(vk::CommandBuffer cmd) const;
     void TransitionForDisplay(vk::CommandBuffer cmd) const;
 
@@ -39,23 +175,109 @@ private:
     static constexpr uint32_t WORK_GROUP_SIZE_Y = 16;
     static constexpr uint32_t WORK_GROUP_SIZE_Z = 1;
 
+    // Persistent kernel: enough resident groups per compute unit to hide latency, a guess when unknown
+    static constexpr uint32_t PERSISTENT_GROUP_SIZE = 64;
+    static constexpr uint32_t PERSISTENT_GROUPS_PER_UNIT = 16;
+    static constexpr uint32_t PERSISTENT_FALLBACK_GROUPS = 1024;
+
+    // Specialization: the traversal stack grows in steps, AA_RATIO mirrors the CPU renderer
+    static constexpr uint32_t BVH_STACK_STEP = 8;
+    static constexpr uint32_t MAX_BVH_STACK_SIZE = 64;
+    static constexpr float AA_RATIO = 1e-3f;
+
+    // Dynamic resolution: lowest fraction of each side traced
+    static constexpr float MIN_RENDER_SCALE = 0.25f;
+
+    // Ray sorting, see sort.glsl
+    static constexpr uint32_t SORT_GROUP_SIZE = 256;
+    static constexpr uint32_t SORT_RADIX = 256;
+    static constexpr uint32_t SORT_PASSES = 3;
+
     // Cache
     uint32_t currentWidth;
     uint32_t currentHeight;
     uint32_t groupCountX = 1;
     uint32_t groupCountY = 1;
     uint32_t groupCountZ = 1;
+    uint32_t persistentGroupCount = 1;
+    float renderScale = 1.0f;
+
+    // CPU copies of the per-frame uniforms
+    CameraData cameraData = {};
+    SceneData sceneData = {};
+    uint64_t cameraVersion = 1;
+    uint64_t sceneVersion = 1;
+    uint64_t bindingsVersion = 1;
 
     // GPU Ressources
-    std::unique_ptr<Image> outputImage;          // Binding 0
-    std::unique_ptr<Buffer> cameraUBO;           // Binding 1
-    std::unique_ptr<Buffer> sceneDataUBO;        // Binding 2
+    std::unique_ptr<Buffer> accumulationBuffer;   // Binding 0, follows the image size
+    std::vector<FrameResources> frames;           // Bindings 1-2
     std::unique_ptr<StorageBuffer> meshesSSBO;    // Binding 3
     std::unique_ptr<StorageBuffer> trianglesSSBO; // Binding 4
     std::unique_ptr<StorageBuffer> bvhNodesSSBO;  // Binding 5
     std::unique_ptr<StorageBuffer> spheresSSBO;  // Binding 6
+    std::unique_ptr<Buffer> rayStatsBuffer;       // Binding 7
+    std::unique_ptr<Buffer> workQueue;            // Binding 13, next pixel of the persistent kernel
+    std::unique_ptr<StorageBuffer> lightsSSBO;    // Binding 16
+    std::unique_ptr<Buffer> pixelStats;           // Binding 17, follows the image size
+    std::unique_ptr<Buffer> tileMask;             // Binding 18, follows the image size
+    std::unique_ptr<Image> outputImage;           // Binding 20, RGBA8 display image written by the resolve
     PushData pushData = {0};
+    uint64_t accumulation = 1; // Incremented whenever sampleIndex restarts from 0
+
+    // Wavefront integrator: one pipeline per stage, state sized by the image and only allocated while in use
+    struct WavefrontPipelines {
+        vk::UniquePipeline generate;
+        vk::UniquePipeline args;
+        vk::UniquePipeline extend;
+        vk::UniquePipeline shade;
+        vk::UniquePipeline miss;
+        vk::UniquePipeline sortKeys;
+        vk::UniquePipeline sortHistogram;
+        vk::UniquePipeline sortScanBlocks;
+        vk::UniquePipeline sortScan;
+        vk::UniquePipeline sortScatter;
+    };
+
+    struct WavefrontResources {
+        std::unique_ptr<Buffer> paths;     // Binding 8
+        std::unique_ptr<Buffer> rayQueues; // Binding 9
+        std::unique_ptr<Buffer> hitQueue;  // Binding 10
+        std::unique_ptr<Buffer> missQueue; // Binding 11
+        std::unique_ptr<Buffer> counters;  // Binding 12, also the indirect dispatch arguments
+        std::unique_ptr<Buffer> sortPairs;      // Binding 14
+        std::unique_ptr<Buffer> sortHistograms; // Binding 15
+    };
+
+    RenderSettings appliedSettings; // Last settings read from the raytracer
+    Integrator integrator = Integrator::Megakernel;
+    bool sortRays = false;
+    bool sortSupported = false; // The device runs workgroups of SORT_GROUP_SIZE invocations
+    uint32_t samplesPerDispatch = 1;
+    float budgetSamples = 1.0f; // Fractional, so that small corrections accumulate
+    WavefrontPipelines wavefrontPipelines;
+    std::unique_ptr<WavefrontResources> wavefront;
+
+    vk::UniquePipeline adaptiveMaskPipeline;
+    vk::UniquePipeline resolvePipeline;
+    bool resolvePending = false;
+    bool adaptiveSampling = false;
+    bool adaptiveMaskValid = false; // Built since the last restart
+
+    std::unique_ptr<TileScheduler> tileScheduler; // Budget set by the renderer, offline renders never tile
+    uint32_t passSamples = 0; // Samples of the tiled pass in progress, fixed when it started
+    bool accumulationStale = true; // Holds another image or layout, cleared before tiles leave parts of it untouched
+
+    std::map<KernelVariant, KernelPipelines> kernelVariants;
+
+    // Scene uploads run on the transfer queue while frames keep using the committed version
+    std::unique_ptr<GpuProfiler> uploadProfiler; // Outlives the uploader, which waits for its last batch
+    std::unique_ptr<Uploader> uploader;
+    SceneData pendingSceneData = {};
+    uint64_t backBuffersFreeAt = 0; // Graphics timeline value after which no frame binds the back buffers
+    uint64_t uploadedBytes = 0;
 
     vk::UniqueImageView outputImageView;
-    vk::UniqueDescriptorSet descriptorSet;
+    // The display image is shared by all frames, the queue orders its accesses
+    mutable vk::ImageLayout outputImageLayout = vk::ImageLayout::eUndefined;
 };
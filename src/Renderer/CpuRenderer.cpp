@@ -0,0 +1,582 @@
+#include "CpuRenderer.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <atomic>
+#include <chrono>
+#include <numbers>
+#include <span>
+#include <thread>
+
+#include <glm/glm.hpp>
+
+#include "Core/Trace.h"
+#include "Traversal/Traversal.h"
+
+// Functions below mirror main.comp one to one, keep them in sync with the shader
+namespace {
+    constexpr uint32_t BVH_STACK_SIZE = 32;
+    constexpr float EPSILON = 1e-4f;
+    constexpr float AA_RATIO = 1e-3f;
+    constexpr float PI = std::numbers::pi_v<float>;
+    constexpr float SHADOW_EPSILON = 1e-3f;
+    constexpr uint32_t BOUNCE_DIMENSIONS = 4;
+
+    struct Ray {
+        glm::vec3 ori;
+        glm::vec3 dir;
+    };
+
+    struct HitInfo {
+        bool didCollide = false;
+        float dst = FLT_MAX;
+        glm::vec3 hitPoint;
+        glm::vec3 normal;
+        Material mat;
+        uint32_t material = 0;
+        uint32_t triangle = 0;
+    };
+
+    // The buffers bound to the compute pipeline
+    struct SceneView {
+        std::span<const Mesh> meshes;
+        std::span<const Triangle> triangles;
+        std::span<const BVH_FlattenNode> nodes;
+        std::span<const Sphere> spheres;
+        std::span<const Light> lights;
+        float lightPower;
+        const CameraData& camera;
+        glm::ivec2 size;
+        uint32_t maxBounces;    // Push constants
+        uint32_t rouletteDepth;
+        uint32_t lightSampling;
+        SampleSequence sampleSequence;
+    };
+
+    uint32_t WangHash(uint32_t seed) {
+        seed = (seed ^ 61u) ^ (seed >> 16u);
+        seed *= 9u;
+        seed = seed ^ (seed >> 4u);
+        seed *= 0x27d4eb2du;
+        seed = seed ^ (seed >> 15u);
+        return seed;
+    }
+
+    float RandomFloat01(uint32_t& state) {
+        state = WangHash(state);
+        return static_cast<float>(state & 0x00FFFFFFu) / static_cast<float>(0x01000000u);
+    }
+
+    struct SampleStream {
+        uint32_t seed;
+        uint32_t pixel;
+        uint32_t index;
+        uint32_t dimension;
+    };
+
+    SampleStream StartSample(const uint32_t pixel, const uint32_t index) {
+        return {pixel + (index + 1) * 41848451u, pixel, index, 0};
+    }
+
+    void StartBounce(SampleStream& stream, const uint32_t bounce) {
+        stream.dimension = 1 + bounce * BOUNCE_DIMENSIONS;
+    }
+
+    // bitfieldReverse() of GLSL
+    uint32_t ReverseBits(uint32_t x) {
+        x = (x << 16) | (x >> 16);
+        x = ((x & 0x00FF00FFu) << 8) | ((x & 0xFF00FF00u) >> 8);
+        x = ((x & 0x0F0F0F0Fu) << 4) | ((x & 0xF0F0F0F0u) >> 4);
+        x = ((x & 0x33333333u) << 2) | ((x & 0xCCCCCCCCu) >> 2);
+        x = ((x & 0x55555555u) << 1) | ((x & 0xAAAAAAAAu) >> 1);
+        return x;
+    }
+
+    uint32_t OwenScramble(uint32_t x, const uint32_t seed) {
+        x = ReverseBits(x);
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return ReverseBits(x);
+    }
+
+    uint32_t Sobol1(uint32_t index) {
+        uint32_t result = 0;
+        for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1) {
+            if (index & 1u) result ^= v;
+        }
+        return result;
+    }
+
+    glm::vec2 SobolOwen(uint32_t index, const uint32_t seed) {
+        index = OwenScramble(index, seed);
+        const uint32_t x = OwenScramble(ReverseBits(index), WangHash(seed ^ 1u));
+        const uint32_t y = OwenScramble(Sobol1(index), WangHash(seed ^ 2u));
+        return glm::vec2(static_cast<float>(x >> 8), static_cast<float>(y >> 8)) / static_cast<float>(0x01000000u);
+    }
+
+    glm::vec2 NextSample2D(const SceneView& scene, SampleStream& stream) {
+        const uint32_t dimension = stream.dimension++;
+        if (scene.sampleSequence == SampleSequence::Sobol) {
+            return SobolOwen(stream.index, WangHash(stream.pixel ^ WangHash(dimension)));
+        }
+
+        // Sequenced explicitly, argument evaluation order is unspecified in C++
+        const float x = RandomFloat01(stream.seed);
+        const float y = RandomFloat01(stream.seed);
+        return {x, y};
+    }
+
+    float NextSample(const SceneView& scene, SampleStream& stream) {
+        if (scene.sampleSequence == SampleSequence::Sobol) return NextSample2D(scene, stream).x;
+
+        stream.dimension++;
+        return RandomFloat01(stream.seed);
+    }
+
+    void Basis(const glm::vec3& n, glm::vec3& tangent, glm::vec3& bitangent) {
+        const float s = n.z >= 0.0f ? 1.0f : -1.0f;
+        const float a = -1.0f / (s + n.z);
+        const float b = n.x * n.y * a;
+        tangent = glm::vec3(1.0f + s * n.x * n.x * a, s * b, -s * n.x);
+        bitangent = glm::vec3(b, s + n.y * n.y * a, -n.y);
+    }
+
+    glm::vec3 CosineSampleHemisphere(const glm::vec3& normal, const glm::vec2 u) {
+        const float r = std::sqrt(u.x);
+        const float phi = 2.0f * PI * u.y;
+
+        glm::vec3 tangent, bitangent;
+        Basis(normal, tangent, bitangent);
+        return glm::normalize(r * std::cos(phi) * tangent + r * std::sin(phi) * bitangent +
+                              std::sqrt(std::max(1.0f - u.x, 0.0f)) * normal);
+    }
+
+    HitInfo RaySphereIntersection(const Ray& ray, const Sphere& sphere) {
+        HitInfo hitInfo;
+
+        const glm::vec3 offsetRayOrigin = ray.ori - sphere.pos;
+        const float a = glm::dot(ray.dir, ray.dir);
+        const float b = 2.0f * glm::dot(offsetRayOrigin, ray.dir);
+        const float c = glm::dot(offsetRayOrigin, offsetRayOrigin) - sphere.rad * sphere.rad;
+        const float discriminant = b * b - 4.0f * a * c;
+
+        if (discriminant >= 0.0f) {
+            const float dst = (-b - std::sqrt(discriminant)) / (2.0f * a);
+            if (dst >= 0.0f) {
+                hitInfo.didCollide = true;
+                hitInfo.dst = dst;
+                hitInfo.hitPoint = ray.ori + dst * ray.dir;
+                hitInfo.normal = glm::normalize(hitInfo.hitPoint - sphere.pos);
+                hitInfo.mat = sphere.mat;
+            }
+        }
+        return hitInfo;
+    }
+
+    HitInfo RayTriangleIntersection(const Ray& ray, const Triangle& triangle) {
+        const glm::vec3 ab = triangle.b - triangle.a;
+        const glm::vec3 ac = triangle.c - triangle.a;
+        const glm::vec3 normal = glm::cross(ab, ac);
+        const glm::vec3 ao = ray.ori - triangle.a;
+        const glm::vec3 dao = glm::cross(ao, ray.dir);
+
+        const float determinant = -glm::dot(ray.dir, normal);
+        const float invDet = 1.0f / determinant;
+
+        const float dst = glm::dot(ao, normal) * invDet;
+        const float u = glm::dot(ac, dao) * invDet;
+        const float v = -glm::dot(ab, dao) * invDet;
+        const float w = 1.0f - u - v;
+
+        HitInfo hitInfo;
+        hitInfo.didCollide = determinant >= 1e-6f && dst >= 0.0f && u >= 0.0f && v >= 0.0f && w >= 0.0f;
+        hitInfo.hitPoint = ray.ori + ray.dir * dst;
+        hitInfo.normal = glm::normalize(normal);
+        hitInfo.dst = dst;
+        return hitInfo;
+    }
+
+    bool RayBoundingBoxIntersection(const Ray& ray, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        const glm::vec3 tMin = (boxMin - ray.ori) / ray.dir;
+        const glm::vec3 tMax = (boxMax - ray.ori) / ray.dir;
+        const glm::vec3 t1 = glm::min(tMin, tMax);
+        const glm::vec3 t2 = glm::max(tMin, tMax);
+        const float tNear = glm::max(glm::max(t1.x, t1.y), t1.z);
+        const float tFar = glm::min(glm::min(t2.x, t2.y), t2.z);
+
+        return tNear <= tFar;
+    }
+
+    HitInfo RayBVHIntersection(const SceneView& scene, const Ray& ray, const Material& mat, const uint32_t startIndex) {
+        HitInfo closest;
+
+        std::array<uint32_t, BVH_STACK_SIZE> stack{};
+        uint32_t stackTopIndex = 0;
+        stack[stackTopIndex++] = startIndex;
+
+        while (stackTopIndex != 0) {
+            const BVH_FlattenNode& currentNode = scene.nodes[stack[--stackTopIndex]];
+
+            if (currentNode.left == 0 && currentNode.right == 0) {
+                for (uint32_t t = currentNode.start; t < currentNode.start + currentNode.count; t++) {
+                    const HitInfo current = RayTriangleIntersection(ray, scene.triangles[t]);
+                    if (current.didCollide && current.dst < closest.dst) {
+                        closest = current;
+                        closest.triangle = t;
+                    }
+                }
+            } else if (RayBoundingBoxIntersection(ray, currentNode.bbox.min, currentNode.bbox.max)) {
+                stack[stackTopIndex++] = currentNode.left;
+                stack[stackTopIndex++] = currentNode.right;
+            }
+        }
+
+        closest.mat = mat;
+        return closest;
+    }
+
+    Ray GenerateRay(const SceneView& scene, const glm::ivec2 pixelCoord, SampleStream& stream) {
+        const glm::vec2 uv = (glm::vec2(pixelCoord) + 0.5f) / glm::vec2(scene.size);
+        glm::vec2 screen = uv * 2.0f - 1.0f;
+        screen.x *= static_cast<float>(scene.size.x / scene.size.y); // Integer division, as in the shader
+
+        const CameraData& camera = scene.camera;
+        const float focalLength = 1.0f / std::tan(camera.fovRad * 0.5f);
+        glm::vec3 rayDir = glm::normalize(screen.x * camera.cameraRight +
+                                          screen.y * camera.cameraUp +
+                                          focalLength * camera.cameraForward);
+
+        // Anti-aliasing
+        const glm::vec2 jitter = NextSample2D(scene, stream) * 2.0f - 1.0f;
+        rayDir += (jitter.x * camera.cameraRight + jitter.y * camera.cameraUp) * AA_RATIO;
+
+        return {camera.cameraPosition, rayDir};
+    }
+
+    HitInfo ClosestHit(const SceneView& scene, const Ray& ray) {
+        HitInfo closest;
+
+        // Spheres
+        for (uint32_t j = 0; j < scene.spheres.size(); j++) {
+            const HitInfo current = RaySphereIntersection(ray, scene.spheres[j]);
+            if (current.didCollide && current.dst < closest.dst) {
+                closest = current;
+                closest.material = j;
+            }
+        }
+
+        // Single BVH Mesh
+        for (uint32_t i = 0; i < scene.meshes.size(); i++) {
+            const Mesh& mesh = scene.meshes[i];
+            const HitInfo current = RayBVHIntersection(scene, ray, mesh.mat, mesh.start);
+            if (current.didCollide && current.dst < closest.dst) {
+                closest = current;
+                closest.material = static_cast<uint32_t>(scene.spheres.size()) + i;
+            }
+        }
+
+        return closest;
+    }
+
+    const Material& GetMaterial(const SceneView& scene, const uint32_t index) {
+        return index < scene.spheres.size() ? scene.spheres[index].mat : scene.meshes[index - scene.spheres.size()].mat;
+    }
+
+    bool RaySphereOccludes(const Ray& ray, const Sphere& sphere, const float tMax) {
+        const glm::vec3 offsetRayOrigin = ray.ori - sphere.pos;
+        const float a = glm::dot(ray.dir, ray.dir);
+        const float b = 2.0f * glm::dot(offsetRayOrigin, ray.dir);
+        const float c = glm::dot(offsetRayOrigin, offsetRayOrigin) - sphere.rad * sphere.rad;
+        const float discriminant = b * b - 4.0f * a * c;
+        if (discriminant < 0.0f) return false;
+
+        const float dst = (-b - std::sqrt(discriminant)) / (2.0f * a);
+        return dst >= 0.0f && dst < tMax;
+    }
+
+    // The mesh part is shared with other CPU callers
+    bool Occluded(const SceneView& scene, const Ray& ray, const float tMax) {
+        for (const Sphere& sphere : scene.spheres) {
+            if (RaySphereOccludes(ray, sphere, tMax)) return true;
+        }
+
+        return Traversal::Occluded(scene.nodes, scene.triangles, scene.meshes, {ray.ori, ray.dir}, tMax);
+    }
+
+    struct LightSample {
+        glm::vec3 dir{};
+        float dst = 0.0f;
+        glm::vec3 radiance{};
+        float pdf = 0.0f;
+    };
+
+    float LightPower(const Material& mat, const float area) {
+        const glm::vec3 emitted = mat.emissionColor * mat.emissionStrength;
+        return (emitted.r + emitted.g + emitted.b) / 3.0f * area;
+    }
+
+    float PowerHeuristic(const float pdf, const float otherPdf) {
+        return pdf * pdf / (pdf * pdf + otherPdf * otherPdf);
+    }
+
+    bool SamplesLights(const SceneView& scene, const Material& mat) {
+        return scene.lightSampling != 0 && !scene.lights.empty() && mat.smoothness == 0.0f;
+    }
+
+    float SphereArea(const Sphere& sphere) {
+        return 4.0f * PI * sphere.rad * sphere.rad;
+    }
+
+    float SphereConePdf(const glm::vec3& point, const Sphere& sphere) {
+        const glm::vec3 toCenter = sphere.pos - point;
+        const float sinThetaMax2 = sphere.rad * sphere.rad / glm::dot(toCenter, toCenter);
+        if (sinThetaMax2 >= 1.0f) return 0.0f;
+
+        const float oneMinusCos = sinThetaMax2 / (1.0f + std::sqrt(1.0f - sinThetaMax2));
+        return 1.0f / (2.0f * PI * oneMinusCos);
+    }
+
+    float LightPdf(const SceneView& scene, const glm::vec3& origin, const HitInfo& hit) {
+        if (hit.material < scene.spheres.size()) {
+            const Sphere& sphere = scene.spheres[hit.material];
+            return LightPower(hit.mat, SphereArea(sphere)) / scene.lightPower * SphereConePdf(origin, sphere);
+        }
+
+        const Triangle& t = scene.triangles[hit.triangle];
+        const float area = 0.5f * glm::length(glm::cross(t.b - t.a, t.c - t.a));
+        const glm::vec3 toLight = hit.hitPoint - origin;
+        const float dst2 = glm::dot(toLight, toLight);
+        const float cosLight = -glm::dot(hit.normal, toLight) / std::sqrt(dst2);
+        return LightPower(hit.mat, area) / scene.lightPower * dst2 / (cosLight * area);
+    }
+
+    float EmissionWeight(const SceneView& scene, const float bsdfPdf, const glm::vec3& origin, const HitInfo& hit) {
+        if (bsdfPdf == 0.0f || LightPower(hit.mat, 1.0f) <= 0.0f) return 1.0f;
+        return PowerHeuristic(bsdfPdf, LightPdf(scene, origin, hit));
+    }
+
+    LightSample SampleLight(const SceneView& scene, const glm::vec3& point, SampleStream& stream) {
+        const float u = NextSample(scene, stream);
+        const glm::vec2 uv = NextSample2D(scene, stream);
+        const float u1 = uv.x;
+        const float u2 = uv.y;
+
+        uint32_t lo = 0;
+        auto hi = static_cast<uint32_t>(scene.lights.size() - 1);
+        while (lo < hi) {
+            const uint32_t mid = (lo + hi) / 2;
+            if (scene.lights[mid].cdf <= u) lo = mid + 1;
+            else hi = mid;
+        }
+        const Light& light = scene.lights[lo];
+        const float selectPdf = light.cdf - (lo > 0 ? scene.lights[lo - 1].cdf : 0.0f);
+
+        const Material& mat = GetMaterial(scene, light.material);
+
+        LightSample result;
+        result.radiance = mat.emissionColor * mat.emissionStrength;
+
+        if (light.material < scene.spheres.size()) {
+            const Sphere& sphere = scene.spheres[light.primitive];
+            const float conePdf = SphereConePdf(point, sphere);
+            if (conePdf == 0.0f) return result;
+
+            const glm::vec3 axis = glm::normalize(sphere.pos - point);
+            const float cosTheta = 1.0f - u1 / (2.0f * PI * conePdf);
+            const float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+            const float phi = 2.0f * PI * u2;
+
+            glm::vec3 tangent, bitangent;
+            Basis(axis, tangent, bitangent);
+            result.dir = glm::normalize(sinTheta * std::cos(phi) * tangent + sinTheta * std::sin(phi) * bitangent +
+                                        cosTheta * axis);
+
+            const HitInfo hit = RaySphereIntersection({point, result.dir}, sphere);
+            if (!hit.didCollide) return result;
+
+            result.dst = hit.dst;
+            result.pdf = selectPdf * conePdf;
+        } else {
+            const Triangle& t = scene.triangles[light.primitive];
+            const float su = std::sqrt(u1);
+            const glm::vec3 target = t.a * (1.0f - su) + t.b * (u2 * su) + t.c * (su - u2 * su);
+
+            const glm::vec3 normal = glm::cross(t.b - t.a, t.c - t.a);
+            const float area = 0.5f * glm::length(normal);
+            const glm::vec3 toLight = target - point;
+            const float dst2 = glm::dot(toLight, toLight);
+            result.dst = std::sqrt(dst2);
+            result.dir = toLight / result.dst;
+
+            const float cosLight = -glm::dot(result.dir, normal) / (2.0f * area);
+            if (cosLight <= 0.0f) return result;
+
+            result.pdf = selectPdf / area * dst2 / cosLight;
+        }
+
+        return result;
+    }
+
+    glm::vec3 DirectLight(const SceneView& scene, const glm::vec3& point, const glm::vec3& normal, const Material& mat,
+                          SampleStream& stream, uint64_t& rayCount) {
+        const LightSample light = SampleLight(scene, point, stream);
+        const float cosine = glm::dot(normal, light.dir);
+        if (light.pdf == 0.0f || cosine <= 0.0f) return glm::vec3(0.0f);
+
+        rayCount++;
+        if (Occluded(scene, {point, light.dir}, light.dst * (1.0f - SHADOW_EPSILON))) return glm::vec3(0.0f);
+
+        const float bsdfPdf = cosine / PI;
+        return mat.color / PI * cosine * light.radiance * PowerHeuristic(light.pdf, bsdfPdf) / light.pdf;
+    }
+
+    glm::vec3 AmbientLight(const Ray& ray) {
+        const glm::vec3 dir = glm::normalize(ray.dir);
+
+        const float t = 0.5f * (dir.y + 1.0f);
+
+        const glm::vec3 horizonColor(1.0f);
+        const glm::vec3 skyColor(0.5f, 0.7f, 1.0f);
+
+        return glm::mix(horizonColor, skyColor, t);
+    }
+
+    bool SurvivesRoulette(const SceneView& scene, const uint32_t depth, glm::vec3& throughput, SampleStream& stream) {
+        if (scene.rouletteDepth == 0 || depth < scene.rouletteDepth) return true;
+
+        const float survival = std::min(std::max(throughput.r, std::max(throughput.g, throughput.b)), 0.95f);
+        if (NextSample(scene, stream) >= survival) return false;
+
+        throughput /= survival;
+        return true;
+    }
+
+    glm::vec3 TracePath(const SceneView& scene, Ray ray, SampleStream& stream, uint64_t& rayCount) {
+        glm::vec3 incomingLight(0.0f);
+        glm::vec3 rayColor(1.0f);
+        float bsdfPdf = 0.0f;
+
+        for (uint32_t i = 0; i < scene.maxBounces; i++) {
+            const HitInfo hitInfo = ClosestHit(scene, ray);
+            rayCount++;
+
+            if (hitInfo.didCollide) {
+                const Material& mat = hitInfo.mat;
+                StartBounce(stream, i);
+                const float weight = EmissionWeight(scene, bsdfPdf, ray.ori, hitInfo);
+                incomingLight += mat.emissionColor * rayColor * mat.emissionStrength * weight;
+
+                ray.ori = hitInfo.hitPoint + hitInfo.normal * EPSILON;
+                const bool sampleLights = SamplesLights(scene, mat);
+                if (sampleLights) {
+                    incomingLight += DirectLight(scene, ray.ori, hitInfo.normal, mat, stream, rayCount) * rayColor;
+                }
+
+                const glm::vec3 diffuseDir = CosineSampleHemisphere(hitInfo.normal, NextSample2D(scene, stream));
+                const glm::vec3 specularDir = glm::reflect(ray.dir, hitInfo.normal);
+                ray.dir = glm::mix(diffuseDir, specularDir, mat.smoothness);
+                bsdfPdf = sampleLights ? glm::dot(diffuseDir, hitInfo.normal) / PI : 0.0f;
+
+                rayColor *= mat.color;
+
+                if (!SurvivesRoulette(scene, i + 1, rayColor, stream)) break;
+            } else {
+                incomingLight += AmbientLight(ray) * rayColor;
+                break;
+            }
+        }
+
+        return incomingLight;
+    }
+}
+
+CpuRenderer::CpuRenderer(const uint32_t threadCount) :
+    threadCount(threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency())) {}
+
+OfflineRenderResult CpuRenderer::Render(const Raytracer& raytracer, const uint32_t samples) const {
+    TRACE_SCOPE("CpuRenderer::Render");
+
+    const auto renderStart = std::chrono::steady_clock::now();
+
+    const Scene& scene = raytracer.GetScene();
+    const SceneData sceneData = scene.GetSceneData();
+    const std::vector<Light> lights = scene.GetLights();
+    const SceneView view{
+        .meshes = std::span(scene.GetMeshes()).first(sceneData.numMeshes),
+        .triangles = scene.GetTriangles(),
+        .nodes = scene.GetBVHNodes(),
+        .spheres = std::span(scene.GetSpheres()).first(sceneData.numSpheres),
+        .lights = lights,
+        .lightPower = sceneData.lightPower,
+        .camera = raytracer.GetCamera().GetData(),
+        .size = glm::ivec2(raytracer.GetWidth(), raytracer.GetHeight()),
+        .maxBounces = std::clamp(raytracer.GetSettings().maxBounces, 1u, MAX_BOUNCES),
+        .rouletteDepth = RouletteDepth(raytracer.GetSettings()),
+        .lightSampling = raytracer.GetSettings().lightSampling,
+        .sampleSequence = raytracer.GetSettings().sampleSequence,
+    };
+
+    OfflineRenderResult result{
+        .width = raytracer.GetWidth(),
+        .height = raytracer.GetHeight(),
+    };
+    result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+    const uint32_t tilesX = (result.width + TILE_SIZE - 1) / TILE_SIZE;
+    const uint32_t tilesY = (result.height + TILE_SIZE - 1) / TILE_SIZE;
+    const uint32_t tileCount = tilesX * tilesY;
+
+    // Tiles are claimed one at a time, threads done with cheap sky tiles take over the rest
+    std::atomic<uint32_t> nextTile = 0;
+    std::atomic<uint64_t> rays = 0;
+
+    const auto worker = [&] {
+        TRACE_SCOPE("CpuRenderer::Worker");
+
+        uint64_t rayCount = 0;
+        for (uint32_t tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            const uint32_t x0 = tile % tilesX * TILE_SIZE;
+            const uint32_t y0 = tile / tilesX * TILE_SIZE;
+
+            for (uint32_t y = y0; y < std::min(y0 + TILE_SIZE, result.height); ++y) {
+                for (uint32_t x = x0; x < std::min(x0 + TILE_SIZE, result.width); ++x) {
+                    // Same running average as StorePixel(), frames are numbered from 1
+                    glm::vec3 accumulated(0.0f);
+                    for (uint32_t frameIndex = 1; frameIndex <= samples; ++frameIndex) {
+                        SampleStream stream = StartSample(y * result.width + x, frameIndex - 1);
+
+                        const Ray ray = GenerateRay(view, glm::ivec2(x, y), stream);
+                        const glm::vec3 color = TracePath(view, ray, stream, rayCount);
+
+                        accumulated = (accumulated * static_cast<float>(frameIndex - 1) + color) /
+                                      static_cast<float>(frameIndex);
+                    }
+
+                    float* pixel = &result.pixels[(static_cast<size_t>(y) * result.width + x) * 4];
+                    pixel[0] = accumulated.r;
+                    pixel[1] = accumulated.g;
+                    pixel[2] = accumulated.b;
+                    pixel[3] = 1.0f;
+                }
+            }
+        }
+
+        rays += rayCount;
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(threadCount - 1);
+        for (uint32_t i = 1; i < threadCount; ++i) threads.emplace_back(worker);
+        worker();
+    }
+
+    result.rays = rays;
+    result.pixelSamples = samples;
+    result.renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+    return result;
+}
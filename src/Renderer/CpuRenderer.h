@@ -0,0 +1,23 @@
+#pragma once
+
+#include "OfflineRenderResult.h"
+#include "Raytracer/Raytracer.h"
+
+// Multithreaded port of shaders/main.comp: same RNG, materials and flattened BVH.
+// Ground truth for shader changes, and fallback on nodes without a Vulkan device.
+class CpuRenderer {
+public:
+    // 0 uses every hardware thread
+    explicit CpuRenderer(uint32_t threadCount = 0);
+
+    // Accumulates the given number of samples per pixel, like HeadlessRenderer::Render()
+    OfflineRenderResult Render(const Raytracer& raytracer, uint32_t samples) const;
+
+    uint32_t GetThreadCount() const { return threadCount; }
+
+private:
+    // Matches the compute work group size
+    static constexpr uint32_t TILE_SIZE = 16;
+
+    uint32_t threadCount;
+};
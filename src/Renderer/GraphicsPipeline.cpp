@@ -8,7 +8,7 @@ GraphicsPipeline::GraphicsPipeline(const std::shared_ptr<VulkanContext>& context
     swapchain(swapchain) {
     CreateSampler();
     CreateDescriptorSetLayout();
-    Pipeline::CreatePipelineLayout();
+    CreatePipelineLayout();
     CreatePipeline();
 }
 
@@ -54,6 +54,7 @@ void GraphicsPipeline::Record(const vk::CommandBuffer cb) const {
     cb.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
 
     cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, descriptorSet.get(), {});
+    cb.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(BlitData), &blitData);
 
     cb.setViewport(0, vp);
     cb.setScissor(0, scissor);
@@ -78,6 +79,35 @@ void GraphicsPipeline::SetImageView(const vk::ImageView newImageView) {
     }
 }
 
+void GraphicsPipeline::SetImageRegion(const uint32_t width, const uint32_t height,
+                                      const uint32_t imageWidth, const uint32_t imageHeight) {
+    const float w = static_cast<float>(imageWidth);
+    const float h = static_cast<float>(imageHeight);
+    blitData = {
+        .uvScaleX = static_cast<float>(width) / w,
+        .uvScaleY = static_cast<float>(height) / h,
+        .uvMaxX = (static_cast<float>(width) - 0.5f) / w,
+        .uvMaxY = (static_cast<float>(height) - 0.5f) / h,
+    };
+}
+
+void GraphicsPipeline::CreatePipelineLayout() {
+    constexpr vk::PushConstantRange pushConstants{
+        .stageFlags = vk::ShaderStageFlagBits::eFragment,
+        .offset = 0,
+        .size = sizeof(BlitData),
+    };
+
+    const vk::PipelineLayoutCreateInfo pipelineLayoutInfo{
+        .setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size()),
+        .pSetLayouts = descriptorSetLayouts.data(),
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstants,
+    };
+
+    pipelineLayout = vulkanContext->device.createPipelineLayout(pipelineLayoutInfo);
+}
+
 void GraphicsPipeline::CreateDescriptorSetLayout() {
     DescriptorSetLayoutBuilder layoutBuilder;
     layoutBuilder.AddBinding(0, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment)
@@ -85,6 +115,8 @@ void GraphicsPipeline::CreateDescriptorSetLayout() {
 }
 
 void GraphicsPipeline::CreateDescriptorSet() {
+    // The previous set may still be bound by a frame in flight
+    if (descriptorSet) vulkanContext->Retire(std::move(descriptorSet));
     descriptorSet = std::move(AllocateDescriptorSets()[0]);
 
     DescriptorSetWriter writer;
@@ -192,8 +224,9 @@ void GraphicsPipeline::CreatePipeline() {
     };
 
     vk::Result result;
-    std::tie(result, pipeline) = vulkanContext->device.createGraphicsPipeline(nullptr, pipelineCreateInfo);
+    std::tie(result, pipeline) = vulkanContext->device.createGraphicsPipeline(vulkanContext->pipelineCache, pipelineCreateInfo);
     if (result != vk::Result::eSuccess) throw std::runtime_error("failed to create graphics pipeline");
+    vulkanContext->TrackCreation();
 }
 
 void GraphicsPipeline::CreateSampler() {
@@ -216,5 +249,6 @@ void GraphicsPipeline::CreateSampler() {
     };
 
     sampler = vulkanContext->device.createSamplerUnique(samplerInfo);
+    vulkanContext->TrackCreation();
 }
 
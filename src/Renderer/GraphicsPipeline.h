@@ -7,6 +7,14 @@
 #include "Vulkan/Swapchain.h"
 #include "Vulkan/VulkanContext.h"
 
+// Region of the display image stretched over the swapchain, see main.frag
+struct BlitData {
+    float uvScaleX = 1.0f;
+    float uvScaleY = 1.0f;
+    float uvMaxX = 1.0f; // Centre of the last texel of the region, bilinear taps stay inside it
+    float uvMaxY = 1.0f;
+};
+
 class GraphicsPipeline final : public Pipeline {
 public:
     GraphicsPipeline(const std::shared_ptr<VulkanContext>& context,
@@ -20,8 +28,12 @@ public:
 
     void SetImageView(vk::ImageView newImageView);
 
+    // Only the top-left width x height pixels of the image are valid, they are upscaled to the swapchain
+    void SetImageRegion(uint32_t width, uint32_t height, uint32_t imageWidth, uint32_t imageHeight);
+
 private:
     void CreateDescriptorSetLayout();
+    void CreatePipelineLayout() override;
     void CreateDescriptorSet();
     void CreatePipeline();
     void CreateSampler();
@@ -33,4 +45,5 @@ private:
 
     vk::ImageView imageView;
     vk::UniqueSampler sampler;
+    BlitData blitData;
 };
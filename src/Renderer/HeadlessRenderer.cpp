@@ -0,0 +1,164 @@
+#include "HeadlessRenderer.h"
+
+#include <chrono>
+
+#include "Core/Trace.h"
+#include "Vulkan/Buffer.h"
+
+HeadlessRenderer::HeadlessRenderer(const std::shared_ptr<VulkanContext>& context) : vulkanContext(context) {
+    computePipeline = std::make_unique<ComputePipeline>(context, FRAMES_IN_FLIGHT);
+    gpuProfiler = std::make_unique<GpuProfiler>(context, context->graphicsQueueIndex, FRAMES_IN_FLIGHT);
+
+    for (auto& slot : slots) {
+        const vk::CommandPoolCreateInfo commandPoolCreateInfo{
+            .flags = vk::CommandPoolCreateFlagBits::eTransient,
+            .queueFamilyIndex = vulkanContext->graphicsQueueIndex,
+        };
+        slot.commandPool = vulkanContext->device.createCommandPool(commandPoolCreateInfo);
+
+        const vk::CommandBufferAllocateInfo commandBufferAllocateInfo{
+            .commandPool = slot.commandPool,
+            .level = vk::CommandBufferLevel::ePrimary,
+            .commandBufferCount = 1
+        };
+        slot.commandBuffer = vulkanContext->device.allocateCommandBuffers(commandBufferAllocateInfo).front();
+        vulkanContext->TrackCreation(2);
+    }
+}
+
+HeadlessRenderer::~HeadlessRenderer() {
+    vulkanContext->device.waitIdle();
+
+    for (const auto& slot : slots) {
+        vulkanContext->device.freeCommandBuffers(slot.commandPool, slot.commandBuffer);
+        vulkanContext->device.destroyCommandPool(slot.commandPool);
+    }
+
+    // Deferred deletions hold resources that keep the context alive
+    computePipeline.reset();
+    vulkanContext->FlushDeletions();
+}
+
+OfflineRenderResult HeadlessRenderer::Render(const Raytracer& raytracer, const uint32_t samples) {
+    using clock = std::chrono::steady_clock;
+
+    // Samples are only counted once the scene is on the GPU, not while the sky is rendered
+    const auto uploadStart = clock::now();
+    computePipeline->Update(raytracer);
+    computePipeline->WaitForSceneUpload();
+    computePipeline->ResetRayStats();
+
+    // Runs with the same traced settings would otherwise add to the previous render
+    computePipeline->RestartAccumulation();
+
+    std::vector<float> frameMs;
+    frameMs.reserve(samples / computePipeline->GetSamplesPerDispatch() + 1);
+
+    const auto renderStart = clock::now();
+    auto lastCompletion = renderStart;
+    uint32_t dispatched = 0;
+    uint32_t lastFrame = 0;
+    for (uint32_t submission = 0; dispatched < samples; ++submission) {
+        const uint32_t frame = submission % FRAMES_IN_FLIGHT;
+        auto& slot = slots[frame];
+
+        {
+            TRACE_SCOPE("HeadlessRenderer::WaitFrameSlot");
+            vulkanContext->graphicsTimeline->Wait(slot.timelineValue);
+        }
+        vulkanContext->CollectGarbage();
+
+        if (submission >= FRAMES_IN_FLIGHT) {
+            const auto now = clock::now();
+            frameMs.push_back(std::chrono::duration<float, std::milli>(now - lastCompletion).count());
+            lastCompletion = now;
+        }
+
+        computePipeline->Update(raytracer);
+
+        // Adaptive sampling ends the render early once every tile is under the threshold
+        if (computePipeline->IsConverged(frame)) break;
+
+        vulkanContext->device.resetCommandPool(slot.commandPool);
+        gpuProfiler->BeginFrame(frame);
+        slot.commandBuffer.begin(vk::CommandBufferBeginInfo{
+            .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit
+        });
+        {
+            GpuScope scope(*gpuProfiler, slot.commandBuffer, "Compute");
+            dispatched += computePipeline->Dispatch(slot.commandBuffer, frame, samples - dispatched);
+        }
+        slot.commandBuffer.end();
+
+        Submit(slot);
+        lastFrame = frame;
+    }
+
+    OfflineRenderResult result = Readback();
+    const auto renderEnd = clock::now();
+
+    // The readback waited for every sample, the last slots are available
+    gpuProfiler->Collect();
+
+    // The readback also waited for the last mask pass, which counted the samples of every pixel
+    const double adaptiveSamples = computePipeline->GetMeanPixelSamples(lastFrame);
+    result.pixelSamples = adaptiveSamples > 0.0 ? adaptiveSamples : computePipeline->GetSampleCount();
+
+    result.frameMs = std::move(frameMs);
+    result.uploadSeconds = std::chrono::duration<double>(renderStart - uploadStart).count();
+    result.renderSeconds = std::chrono::duration<double>(renderEnd - renderStart).count();
+    return result;
+}
+
+void HeadlessRenderer::Submit(FrameSlot& slot) const {
+    std::vector<vk::SemaphoreSubmitInfo> waitInfos;
+    if (const uint64_t uploadValue = computePipeline->ConsumeUploadWait()) {
+        waitInfos.push_back(vulkanContext->transferTimeline->SubmitInfo(
+            uploadValue, vk::PipelineStageFlagBits2::eComputeShader));
+    }
+
+    slot.timelineValue = vulkanContext->graphicsTimeline->Next();
+    const vk::SemaphoreSubmitInfo signalInfo = vulkanContext->graphicsTimeline->SubmitInfo(
+        slot.timelineValue, vk::PipelineStageFlagBits2::eAllCommands);
+
+    const vk::CommandBufferSubmitInfo commandBufferInfo{.commandBuffer = slot.commandBuffer};
+
+    const vk::SubmitInfo2 submitInfo{
+        .waitSemaphoreInfoCount = static_cast<uint32_t>(waitInfos.size()),
+        .pWaitSemaphoreInfos = waitInfos.data(),
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &commandBufferInfo,
+        .signalSemaphoreInfoCount = 1,
+        .pSignalSemaphoreInfos = &signalInfo,
+    };
+
+    vulkanContext->graphicsQueue.submit2(submitInfo);
+}
+
+OfflineRenderResult HeadlessRenderer::Readback() const {
+    OfflineRenderResult result{
+        .width = computePipeline->GetWidth(),
+        .height = computePipeline->GetHeight(),
+    };
+
+    const size_t pixelCount = static_cast<size_t>(result.width) * result.height;
+    const Buffer readbackBuffer(vulkanContext, pixelCount * 3 * sizeof(float), vk::BufferUsageFlagBits::eTransferDst);
+
+    // Submitted after every sample on the same queue, and waited on before returning
+    const vk::CommandBuffer cmd = vulkanContext->BeginSingleTimeCommands();
+    computePipeline->RecordReadback(cmd, readbackBuffer);
+    vulkanContext->EndSingleTimeCommands(cmd);
+
+    // The accumulation is packed RGB, results are RGBA like the CPU renderer's
+    std::vector<float> rgb;
+    readbackBuffer.Read(rgb);
+    result.pixels.resize(pixelCount * 4);
+    for (size_t i = 0; i < pixelCount; ++i) {
+        result.pixels[i * 4] = rgb[i * 3];
+        result.pixels[i * 4 + 1] = rgb[i * 3 + 1];
+        result.pixels[i * 4 + 2] = rgb[i * 3 + 2];
+        result.pixels[i * 4 + 3] = 1.0f;
+    }
+    result.rays = computePipeline->GetRayCount();
+    return result;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+
+#include "ComputePipeline.h"
+#include "OfflineRenderResult.h"
+#include "Raytracer/Raytracer.h"
+#include "Vulkan/Base.h"
+#include "Vulkan/GpuProfiler.h"
+#include "Vulkan/VulkanContext.h"
+
+// Drives the compute pipeline without a window or swapchain, for batch rendering
+class HeadlessRenderer {
+public:
+    explicit HeadlessRenderer(const std::shared_ptr<VulkanContext>& context);
+    ~HeadlessRenderer();
+
+    // Accumulates the given number of samples per pixel, then reads the image back
+    OfflineRenderResult Render(const Raytracer& raytracer, uint32_t samples);
+
+    uint64_t GetUploadedBytes() const { return computePipeline->GetUploadedBytes(); }
+    uint32_t GetPersistentGroupCount() const { return computePipeline->GetPersistentGroupCount(); }
+
+    // Accumulated over every Render() call
+    const GpuProfiler& GetGpuProfiler() const { return *gpuProfiler; }
+    const GpuProfiler& GetUploadProfiler() const { return computePipeline->GetUploadProfiler(); }
+
+    HeadlessRenderer(const HeadlessRenderer&) = delete;
+    HeadlessRenderer& operator=(const HeadlessRenderer&) = delete;
+
+private:
+    struct FrameSlot {
+        vk::CommandPool commandPool = nullptr;
+        vk::CommandBuffer commandBuffer = nullptr;
+        uint64_t timelineValue = 0;
+    };
+
+    void Submit(FrameSlot& slot) const;
+    OfflineRenderResult Readback() const;
+
+private:
+    static constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+
+    std::shared_ptr<VulkanContext> vulkanContext;
+    std::unique_ptr<ComputePipeline> computePipeline;
+    std::unique_ptr<GpuProfiler> gpuProfiler;
+
+    std::array<FrameSlot, FRAMES_IN_FLIGHT> slots;
+};
@@ -36,6 +36,7 @@ ImGuiPipeline::ImGuiPipeline(const std::shared_ptr<VulkanContext>& context,
         .DescriptorPool = context->mainDescriptorPool,
         .MinImageCount = 2,
         .ImageCount = swapchain->GetImageCount(),
+        .PipelineCache = context->pipelineCache,
         .UseDynamicRendering = true,
         .PipelineRenderingCreateInfo = pipelineRenderingInfo,
     };
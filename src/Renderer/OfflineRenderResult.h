@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Output of the offline renderers, on the GPU or the CPU
+struct OfflineRenderResult {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> pixels; // Linear RGBA32F, rows from top to bottom
+
+    // Interval between consecutive sample completions, the last ones are folded into the readback
+    std::vector<float> frameMs;
+
+    uint64_t rays = 0;
+    double pixelSamples = 0.0;  // Mean per pixel, below the requested count where adaptive sampling stopped early
+    double uploadSeconds = 0.0; // Scene upload before the first sample
+    double renderSeconds = 0.0; // From the first dispatch to the readback
+};
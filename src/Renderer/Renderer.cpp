@@ -1,37 +1,131 @@
 #include "Renderer.h"
 
+#include <fstream>
+
 #include <imgui.h>
 
+#include "Core/Log.h"
+#include "Core/Trace.h"
+
 Renderer::Renderer(const std::shared_ptr<Window>& window,
                    const std::shared_ptr<VulkanContext>& context) :
     window(window),
     vulkanContext(context) {
     swapchain = std::make_shared<Swapchain>(context, window);
-    computePipeline = std::make_unique<ComputePipeline>(context);
+    acquireSemaphores = std::make_unique<SemaphorePool>(context);
+    gpuProfiler = std::make_unique<GpuProfiler>(context, context->graphicsQueueIndex, Swapchain::MAX_FRAMES_IN_FLIGHT);
+    computePipeline = std::make_unique<ComputePipeline>(context, Swapchain::MAX_FRAMES_IN_FLIGHT);
     graphicsPipeline = std::make_unique<GraphicsPipeline>(context, swapchain);
     uiPipeline = std::make_unique<ImGuiPipeline>(context, window, swapchain);
 }
 
 Renderer::~Renderer() {
-    if (vulkanContext->device) vulkanContext->device.waitIdle();
+    if (vulkanContext->device) {
+        vulkanContext->device.waitIdle();
+
+        // Deferred deletions hold resources that keep the context alive
+        vulkanContext->FlushDeletions();
+    }
 }
 
 void Renderer::Draw() const {
     if (const auto fc = BeginFrame()) {
-        computePipeline->Dispatch(fc->commandBuffer);
-        graphicsPipeline->SetImageView(computePipeline->GetImageView());
-        graphicsPipeline->Record(fc->commandBuffer);
-        uiPipeline->Record(fc->commandBuffer);
+        // At the sample target, or once adaptive sampling converged, the GPU only draws the accumulated
+        // image until the next restart
+        const uint32_t sampleCount = computePipeline->GetSampleCount();
+        const bool targetReached = sampleTarget != 0 && sampleCount >= sampleTarget;
+        drewCachedImage = targetReached || computePipeline->IsConverged(fc->frame);
+        if (!drewCachedImage) {
+            {
+                GpuScope scope(*gpuProfiler, fc->commandBuffer, "Compute");
+                computePipeline->Dispatch(fc->commandBuffer, fc->frame,
+                                          sampleTarget != 0 ? sampleTarget - sampleCount : UINT32_MAX);
+            }
+
+            // Cached frames keep drawing the last resolve
+            GpuScope scope(*gpuProfiler, fc->commandBuffer, "Resolve");
+            computePipeline->Resolve(fc->commandBuffer, fc->frame);
+        } else if (computePipeline->IsResolvePending()) {
+            GpuScope scope(*gpuProfiler, fc->commandBuffer, "Resolve");
+            computePipeline->Resolve(fc->commandBuffer, fc->frame);
+        }
+        {
+            GpuScope scope(*gpuProfiler, fc->commandBuffer, "Graphics");
+            graphicsPipeline->SetImageView(computePipeline->GetImageView());
+            graphicsPipeline->SetImageRegion(computePipeline->GetTraceWidth(), computePipeline->GetTraceHeight(),
+                                             computePipeline->GetWidth(), computePipeline->GetHeight());
+            graphicsPipeline->Record(fc->commandBuffer);
+        }
+        {
+            GpuScope scope(*gpuProfiler, fc->commandBuffer, "UI");
+            uiPipeline->Record(fc->commandBuffer);
+        }
 
         Submit(*fc);
         Present(*fc);
+        swapchain->AdvanceFrame();
     } else {
         uiPipeline->End();
+        drewCachedImage = false;
     }
 }
 
 void Renderer::Update(const Raytracer& raytracer) const {
+    // The compute pipeline clears the camera flag, the motion is sampled first
+    if (raytracer.IsDirty(DirtyFlags::Camera)) framesSinceMotion = 0;
+    else if (framesSinceMotion < MOTION_HOLD_FRAMES) framesSinceMotion++;
+
     computePipeline->Update(raytracer);
+
+    const RenderSettings& settings = raytracer.GetSettings();
+    sampleTarget = settings.maxSamples;
+
+    // Timestamps of the last frame read back without waiting
+    float computeMs = 0.0f;
+    for (const auto& scope : gpuProfiler->GetStats()) {
+        if (scope.name == "Compute") computeMs = scope.lastMs;
+    }
+
+    // While the camera moves every frame restarts: the traced extent shrinks to keep the frame time instead of
+    // splitting it into tiles, and returns to full resolution once the camera stopped
+    const bool scaling = settings.motionFrameMs > 0.0f && framesSinceMotion < MOTION_HOLD_FRAMES;
+    if (scaling) computePipeline->FitRenderScale(settings.motionFrameMs, computeMs);
+    else computePipeline->SetRenderScale(1.0f);
+    computePipeline->SetTileBudget(scaling ? 0.0f : settings.tileBudgetMs);
+
+    // Tiles already fit the budget, the samples of their passes stay fixed
+    const float budgetMs = settings.frameBudgetMs;
+    if (budgetMs <= 0.0f || scaling || computePipeline->IsTiled()) return;
+
+    computePipeline->FitSamplesToBudget(budgetMs, computeMs);
+}
+
+bool Renderer::IsIdle() const {
+    // A reduced render scale still has to return to full resolution
+    return drewCachedImage && !computePipeline->IsUploading() && framesSinceMotion == MOTION_HOLD_FRAMES;
+}
+
+void Renderer::ResetGpuStats() const {
+    gpuProfiler->ResetStats();
+    computePipeline->ResetUploadStats();
+}
+
+void Renderer::SaveGpuProfile(const std::filesystem::path& filepath) const {
+    std::ofstream write(filepath);
+    if (!write.is_open()) {
+        LOGE("Failed to open file: {}", filepath.string());
+        return;
+    }
+
+    const Json profile = {
+        {"device", vulkanContext->physicalDevice.getProperties().deviceName.data()},
+        {"presentedFrames", frameStats.presentedFrames},
+        {"gpuScopes", gpuProfiler->ToJson()},
+        {"uploadScopes", GetUploadProfiler().ToJson()},
+    };
+
+    write << std::setw(4) << profile << std::endl;
+    LOGI("Saved GPU profile: {}", filepath.string());
 }
 
 void Renderer::Begin() const {
@@ -39,11 +133,11 @@ void Renderer::Begin() const {
 }
 
 FrameContext* Renderer::BeginFrame() const {
+    TRACE_SCOPE("Renderer::BeginFrame");
+
     const auto result = AcquireNextImage();
     if (!result) {
-        if (result.error() == AcquireError::Failed) vulkanContext->device.waitIdle();
-        else Resize();
-        swapchain->ResetCurrentImageIndex();
+        if (result.error() == AcquireError::OutOfDate) Resize();
         return nullptr;
     }
 
@@ -51,6 +145,9 @@ FrameContext* Renderer::BeginFrame() const {
 
     vulkanContext->device.resetCommandPool(fc->commandPool);
 
+    // The slot's previous timestamps are complete, like its command buffer
+    gpuProfiler->BeginFrame(fc->frame);
+
     fc->commandBuffer.begin(vk::CommandBufferBeginInfo{
         .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit
     });
@@ -69,7 +166,9 @@ FrameContext* Renderer::BeginFrame() const {
     return fc;
 }
 
-void Renderer::Submit(const FrameContext& fc) const {
+void Renderer::Submit(FrameContext& fc) const {
+    TRACE_SCOPE("Renderer::Submit");
+
     vkHelpers::TransitionImageLayout(fc.commandBuffer,
                                      swapchain->GetImages()[fc.index],
                                      vk::ImageLayout::eColorAttachmentOptimal,
@@ -82,26 +181,50 @@ void Renderer::Submit(const FrameContext& fc) const {
 
     fc.commandBuffer.end();
 
-    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+    std::vector<vk::SemaphoreSubmitInfo> waitInfos = {
+        {
+            .semaphore = fc.imageAvailable,
+            .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+        }
+    };
 
-    const vk::SubmitInfo submitInfo{
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &fc.imageAvailable.get(),
-        .pWaitDstStageMask = &waitStage,
-        .commandBufferCount = 1,
-        .pCommandBuffers = &fc.commandBuffer,
-        .signalSemaphoreCount = 1,
-        .pSignalSemaphores = &fc.renderFinished
+    if (const uint64_t uploadValue = computePipeline->ConsumeUploadWait()) {
+        waitInfos.push_back(vulkanContext->transferTimeline->SubmitInfo(
+            uploadValue, vk::PipelineStageFlagBits2::eComputeShader));
+    }
+
+    fc.timelineValue = vulkanContext->graphicsTimeline->Next();
+
+    const std::array signalInfos = {
+        vk::SemaphoreSubmitInfo{
+            .semaphore = swapchain->GetRenderFinished(fc.index),
+            .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+        },
+        vulkanContext->graphicsTimeline->SubmitInfo(fc.timelineValue, vk::PipelineStageFlagBits2::eAllCommands),
     };
 
-    vulkanContext->graphicsQueue.submit(submitInfo, fc.inFlight);
+    const vk::CommandBufferSubmitInfo commandBufferInfo{.commandBuffer = fc.commandBuffer};
+
+    const vk::SubmitInfo2 submitInfo{
+        .waitSemaphoreInfoCount = static_cast<uint32_t>(waitInfos.size()),
+        .pWaitSemaphoreInfos = waitInfos.data(),
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &commandBufferInfo,
+        .signalSemaphoreInfoCount = static_cast<uint32_t>(signalInfos.size()),
+        .pSignalSemaphoreInfos = signalInfos.data(),
+    };
+
+    vulkanContext->graphicsQueue.submit2(submitInfo);
 }
 
 void Renderer::Present(const FrameContext& fc) const {
+    TRACE_SCOPE("Renderer::Present");
+
     auto sc = swapchain->GetSwapchain();
+    const vk::Semaphore renderFinished = swapchain->GetRenderFinished(fc.index);
     const vk::PresentInfoKHR presentInfo{
         .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &fc.renderFinished,
+        .pWaitSemaphores = &renderFinished,
         .swapchainCount = 1,
         .pSwapchains = &sc,
         .pImageIndices = &fc.index
@@ -109,6 +232,7 @@ void Renderer::Present(const FrameContext& fc) const {
 
     try {
         const auto result = vulkanContext->graphicsQueue.presentKHR(presentInfo);
+        frameStats.presentedFrames++;
         if (result == vk::Result::eSuboptimalKHR) Resize();
     } catch (vk::OutOfDateKHRError&) {
         Resize();
@@ -116,31 +240,46 @@ void Renderer::Present(const FrameContext& fc) const {
 }
 
 std::expected<FrameContext*, Renderer::AcquireError> Renderer::AcquireNextImage() const {
-    auto acquireSemaphore = vulkanContext->device.createSemaphoreUnique({});
+    auto& frame = swapchain->GetCurrentFrameContext();
+
+    // The slot's command buffer and semaphore are reused once its previous submission is done
+    const auto waitStart = std::chrono::steady_clock::now();
+    const bool gpuStarved = vulkanContext->graphicsTimeline->IsComplete(frame.timelineValue);
+    {
+        TRACE_SCOPE("Renderer::WaitFrameSlot");
+        vulkanContext->graphicsTimeline->Wait(frame.timelineValue);
+    }
+    RecordFrameTimings(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitStart).count(),
+                       gpuStarved);
+
+    vulkanContext->CollectGarbage();
+
+    // The submission that waited on the slot's previous semaphore is complete
+    acquireSemaphores->Recycle(std::exchange(frame.imageAvailable, nullptr));
+    const vk::Semaphore acquireSemaphore = acquireSemaphores->Acquire();
 
     uint32_t imageIndex;
     vk::Result result;
 
     try {
+        TRACE_SCOPE("Renderer::AcquireImage");
         std::tie(result, imageIndex) = vulkanContext->device.acquireNextImageKHR(
-            swapchain->GetSwapchain(), UINT64_MAX, acquireSemaphore.get());
+            swapchain->GetSwapchain(), UINT64_MAX, acquireSemaphore);
     } catch (vk::OutOfDateKHRError&) {
+        // Nothing was signaled, the semaphore can be reused as is
+        acquireSemaphores->Recycle(acquireSemaphore);
         return std::unexpected(AcquireError::OutOfDate);
     }
 
-    if (result == vk::Result::eSuboptimalKHR) return std::unexpected(AcquireError::Suboptimal);
-    if (result != vk::Result::eSuccess) return std::unexpected(AcquireError::Failed);
-
-    swapchain->SetCurrentImageIndex(imageIndex);
-    auto& frame = swapchain->GetCurrentFrameContext();
-
-    if (frame.inFlight) {
-        const auto waitResult = vulkanContext->device.waitForFences(frame.inFlight, true, UINT64_MAX);
-        assert(waitResult == vk::Result::eSuccess);
-        vulkanContext->device.resetFences(frame.inFlight);
+    // A suboptimal image is still acquired and its semaphore signaled: render it and let Present() resize
+    if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) {
+        vulkanContext->device.waitIdle();
+        acquireSemaphores->Recycle(acquireSemaphore);
+        return std::unexpected(AcquireError::Failed);
     }
 
-    frame.imageAvailable = std::move(acquireSemaphore);
+    frame.index = imageIndex;
+    frame.imageAvailable = acquireSemaphore;
 
     return &frame;
 }
@@ -148,7 +287,25 @@ std::expected<FrameContext*, Renderer::AcquireError> Renderer::AcquireNextImage(
 void Renderer::Resize() const {
     window->WaitWhileMinimized();
 
-    vulkanContext->device.waitIdle();
-
+    // Resources of the old swapchain are retired, not waited on
     swapchain->Recreate();
+
+    // The new images are only drawn by the next frame
+    drewCachedImage = false;
+}
+
+void Renderer::RecordFrameTimings(const float fenceWaitMs, const bool gpuStarved) const {
+    const auto now = std::chrono::steady_clock::now();
+    const float frameMs = std::chrono::duration<float, std::milli>(now - lastFrameStart).count();
+    lastFrameStart = now;
+
+    // Exponential moving averages keep the values readable from one frame to the next
+    constexpr float smoothing = 0.05f;
+    frameStats.cpuFrameMs += smoothing * (frameMs - fenceWaitMs - frameStats.cpuFrameMs);
+    frameStats.fenceWaitMs += smoothing * (fenceWaitMs - frameStats.fenceWaitMs);
+    frameStats.gpuStarvedRatio += smoothing * ((gpuStarved ? 1.0f : 0.0f) - frameStats.gpuStarvedRatio);
+
+    // Steady-state frames are expected to report zero here
+    frameStats.objectCreations = vulkanContext->ConsumeObjectCreations();
+    frameStats.totalObjectCreations += frameStats.objectCreations;
 }
@@ -1,12 +1,28 @@
 #pragma once
 
+#include <chrono>
+#include <filesystem>
+
 #include "ComputePipeline.h"
 #include "GraphicsPipeline.h"
 #include "ImGuiPipeline.h"
 #include "Vulkan/Base.h"
+#include "Vulkan/GpuProfiler.h"
+#include "Vulkan/SemaphorePool.h"
 #include "Vulkan/VulkanContext.h"
 #include "Vulkan/Swapchain.h"
 
+struct FrameStats {
+    float cpuFrameMs = 0.0f;      // Frame period minus the time blocked on the GPU
+    float fenceWaitMs = 0.0f;     // CPU blocked on the frame slot's timeline value
+    float gpuStarvedRatio = 0.0f; // Frames whose slot was already idle when the CPU got to it
+
+    uint32_t objectCreations = 0;      // Vulkan objects created since the previous frame
+    uint64_t totalObjectCreations = 0;
+
+    uint64_t presentedFrames = 0;
+};
+
 class Renderer {
 public:
     explicit Renderer(const std::shared_ptr<Window>& window,
@@ -18,14 +34,29 @@ public:
     void Draw() const;
     void Update(const Raytracer& raytracer) const;
 
+    // The last frame only drew the cached image and no scene upload is pending: nothing changes until input
+    bool IsIdle() const;
+
+    const FrameStats& GetFrameStats() const { return frameStats; }
+    uint32_t GetSampleCount() const { return computePipeline->GetSampleCount(); }
+    uint32_t GetSamplesPerDispatch() const { return computePipeline->GetSamplesPerDispatch(); }
+    float GetRenderScale() const { return computePipeline->GetRenderScale(); }
+    // Only while passes are split into tiles
+    const TileScheduler* GetTileScheduler() const {
+        return computePipeline->IsTiled() ? &computePipeline->GetTileScheduler() : nullptr;
+    }
+    const GpuProfiler& GetGpuProfiler() const { return *gpuProfiler; }
+    const GpuProfiler& GetUploadProfiler() const { return computePipeline->GetUploadProfiler(); }
+    void ResetGpuStats() const;
+    void SaveGpuProfile(const std::filesystem::path& filepath) const;
+
 private:
     FrameContext* BeginFrame() const;
-    void Submit(const FrameContext& fc) const;
+    void Submit(FrameContext& fc) const;
     void Present(const FrameContext& fc) const;
 
 private:
     enum class AcquireError {
-        Suboptimal,
         OutOfDate,
         Failed,
     };
@@ -33,8 +64,13 @@ private:
     std::expected<FrameContext*, AcquireError> AcquireNextImage() const;
 
     void Resize() const;
+    void RecordFrameTimings(float fenceWaitMs, bool gpuStarved) const;
 
 private:
+    // Frames without camera motion before the render scale returns to full resolution, so that a frame
+    // without input in the middle of a drag does not trace a full-resolution frame
+    static constexpr uint32_t MOTION_HOLD_FRAMES = 3;
+
     std::shared_ptr<Window> window;
     std::shared_ptr<VulkanContext> vulkanContext;
     std::shared_ptr<Swapchain> swapchain;
@@ -42,4 +78,14 @@ private:
     std::unique_ptr<ComputePipeline> computePipeline;
     std::unique_ptr<GraphicsPipeline> graphicsPipeline;
     std::unique_ptr<ImGuiPipeline> uiPipeline;
+
+    std::unique_ptr<SemaphorePool> acquireSemaphores;
+    std::unique_ptr<GpuProfiler> gpuProfiler;
+
+    mutable uint32_t sampleTarget = 0; // Max samples of the render settings, 0 never stops
+    mutable bool drewCachedImage = false; // The last frame dispatched nothing, and presented to a valid swapchain
+    mutable uint32_t framesSinceMotion = MOTION_HOLD_FRAMES; // Saturates at MOTION_HOLD_FRAMES
+
+    mutable FrameStats frameStats;
+    mutable std::chrono::steady_clock::time_point lastFrameStart;
 };
@@ -0,0 +1,115 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+#include "Core/Log.h"
+
+namespace {
+    uint32_t PackTile(const uint32_t x, const uint32_t y) {
+        return x | y << 16;
+    }
+
+    // Distance along the Hilbert curve covering an n x n grid, n a power of two
+    uint32_t HilbertIndex(const uint32_t n, uint32_t x, uint32_t y) {
+        uint32_t d = 0;
+        for (uint32_t s = n / 2; s > 0; s /= 2) {
+            const uint32_t rx = (x & s) > 0 ? 1 : 0;
+            const uint32_t ry = (y & s) > 0 ? 1 : 0;
+            d += s * s * (3 * rx ^ ry);
+
+            // Rotates the quadrant so that the sub-curve starts at its origin
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = n - 1 - x;
+                    y = n - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+}
+
+TileScheduler::TileScheduler(const std::shared_ptr<VulkanContext>& context, const uint32_t framesInFlight) :
+    profiler(std::make_unique<GpuProfiler>(context, context->graphicsQueueIndex, framesInFlight, 1)),
+    slotTiles(framesInFlight, 0) {
+    if (!profiler->IsEnabled()) LOGW("Tile scheduler has no timestamps, {} tiles per frame", INITIAL_TILES);
+}
+
+void TileScheduler::Resize(const uint32_t width, const uint32_t height) {
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    BuildOrder();
+}
+
+void TileScheduler::SetOrder(const TileOrder order) {
+    if (order == tileOrder) return;
+    tileOrder = order;
+
+    // The tiles traced so far would be traced again in the pass, the new order waits for the next one
+    if (IsPassStart()) BuildOrder();
+    else orderPending = true;
+}
+
+void TileScheduler::BeginFrame(const uint32_t slot) {
+    profiler->BeginFrame(slot);
+
+    const uint32_t tiles = std::exchange(slotTiles[slot], 0);
+    if (tiles == 0) return;
+
+    for (const auto& scope : profiler->GetStats()) {
+        if (scope.name == SCOPE_NAME) FitToBudget(tiles, scope.lastMs);
+    }
+}
+
+const std::vector<uint32_t>& TileScheduler::NextTiles(const uint32_t slot) {
+    if (orderPending && IsPassStart()) BuildOrder();
+
+    // A pass ends on its last tile, the next one starts with the next frame
+    const size_t count = std::min(static_cast<size_t>(budgetTiles), order.size() - cursor);
+    batch.assign(order.begin() + static_cast<ptrdiff_t>(cursor),
+                 order.begin() + static_cast<ptrdiff_t>(cursor + count));
+    cursor += count;
+
+    slotTiles[slot] = static_cast<uint32_t>(count);
+    return batch;
+}
+
+void TileScheduler::BuildOrder() {
+    order.clear();
+    order.reserve(static_cast<size_t>(tilesX) * tilesY);
+    for (uint32_t y = 0; y < tilesY; ++y) {
+        for (uint32_t x = 0; x < tilesX; ++x) order.push_back(PackTile(x, y));
+    }
+
+    if (tileOrder == TileOrder::Spiral) {
+        // Square rings around the centre, each one swept by angle
+        const float centerX = static_cast<float>(tilesX) * 0.5f;
+        const float centerY = static_cast<float>(tilesY) * 0.5f;
+        const auto key = [&](const uint32_t tile) {
+            const float dx = static_cast<float>(tile & 0xFFFF) + 0.5f - centerX;
+            const float dy = static_cast<float>(tile >> 16) + 0.5f - centerY;
+            return std::pair(std::max(std::abs(dx), std::abs(dy)), std::atan2(dy, dx));
+        };
+        std::ranges::sort(order, {}, key);
+    } else {
+        const uint32_t n = std::bit_ceil(std::max({tilesX, tilesY, 1u}));
+        std::ranges::sort(order, {}, [&](const uint32_t tile) { return HilbertIndex(n, tile & 0xFFFF, tile >> 16); });
+    }
+
+    budgetTiles = std::min(budgetTiles, static_cast<float>(std::max<size_t>(order.size(), 1)));
+    cursor = 0;
+    orderPending = false;
+}
+
+void TileScheduler::FitToBudget(const uint32_t tiles, const float ms) {
+    if (ms <= 0.0f || budgetMs <= 0.0f) return;
+
+    // Same damping as the samples per dispatch: the measurement is a few frames old
+    const float scale = std::clamp(std::sqrt(budgetMs / ms), 0.5f, 2.0f);
+    const float total = static_cast<float>(std::max<size_t>(order.size(), 1));
+    budgetTiles = std::clamp(static_cast<float>(tiles) * scale, 1.0f, total);
+}
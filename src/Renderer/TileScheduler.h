@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include "Raytracer/RenderSettings.h"
+#include "Vulkan/GpuProfiler.h"
+#include "Vulkan/VulkanContext.h"
+
+// Spreads the passes of the megakernel over several frames: each frame traces the next tiles of the pass,
+// as many as fit the GPU budget. The tiles are timed with the scheduler's own queries, a frame slot's
+// measurement is read when the slot comes around again.
+class TileScheduler {
+public:
+    // Pixels per side of a tile, a whole number of megakernel workgroups
+    static constexpr uint32_t TILE_SIZE = 64;
+
+    TileScheduler(const std::shared_ptr<VulkanContext>& context, uint32_t framesInFlight);
+
+    void Resize(uint32_t width, uint32_t height);
+    void SetOrder(TileOrder order);
+    void SetBudget(const float ms) { budgetMs = ms; }
+    bool IsEnabled() const { return budgetMs > 0.0f; }
+
+    // Starts the next pass from the first tile of the order
+    void Restart() { cursor = 0; }
+    bool IsPassStart() const { return cursor == 0; }
+    bool IsPassComplete() const { return cursor == order.size(); }
+
+    // The caller waited for the slot's previous submission: its timing resizes the next batches
+    void BeginFrame(uint32_t slot);
+
+    // Next tiles of the pass for this slot, packed as x | y << 16 in tile units
+    const std::vector<uint32_t>& NextTiles(uint32_t slot);
+
+    // Times the commands recorded during its lifetime, the dispatch of the tiles returned by NextTiles()
+    GpuScope TimeTiles(const vk::CommandBuffer cmd) { return GpuScope(*profiler, cmd, SCOPE_NAME); }
+
+    uint32_t GetTileCount() const { return static_cast<uint32_t>(order.size()); }
+    uint32_t GetTilesPerFrame() const { return static_cast<uint32_t>(budgetTiles); }
+
+    TileScheduler(const TileScheduler&) = delete;
+    TileScheduler& operator=(const TileScheduler&) = delete;
+
+private:
+    void BuildOrder();
+    void FitToBudget(uint32_t tiles, float ms);
+
+private:
+    static constexpr float INITIAL_TILES = 4.0f;
+    static constexpr std::string_view SCOPE_NAME = "Tiles";
+
+    std::unique_ptr<GpuProfiler> profiler;
+
+    TileOrder tileOrder = TileOrder::Spiral;
+    bool orderPending = false; // Changed during a pass, the order is rebuilt when the next one starts
+    uint32_t tilesX = 0;
+    uint32_t tilesY = 0;
+    std::vector<uint32_t> order; // Every tile of the image, in the order of the passes
+    size_t cursor = 0;           // First tile of the pass not traced yet
+
+    float budgetMs = 0.0f;
+    float budgetTiles = INITIAL_TILES; // Fractional, so that small corrections accumulate
+    std::vector<uint32_t> slotTiles;   // Tiles timed by each slot's pending measurement, 0 if none
+    std::vector<uint32_t> batch;
+};
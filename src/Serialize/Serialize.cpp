@@ -128,6 +128,7 @@ void to_json(Json& j, const SceneData& sceneData) {
         {"numMeshes", sceneData.numMeshes},
         {"numTriangles", sceneData.numTriangles},
         {"numSpheres", sceneData.numSpheres},
+        {"numLights", sceneData.numLights},
     };
 }
 
@@ -139,17 +140,36 @@ void from_json(const Json& j, SceneData& sceneData) {
 
 // ---- Scene ----
 void to_json(Json& j, const Scene& scene) {
+    // Meshes are saved as their source file, triangles and BVH nodes are rebuilt on load
+    Json meshes = Json::array();
+    for (size_t i = 0; i < scene.meshes.size(); ++i) {
+        meshes.push_back({
+            {"path", scene.meshPaths[i].generic_string()},
+            {"material", scene.meshes[i].mat},
+        });
+    }
+
     j = Json{
         {"sceneData", scene.GetSceneData()},
         {"spheres", scene.spheres},
-        // TODO save meshes; triangles; bvhNodes;
+        {"meshes", meshes},
     };
 }
 
 void from_json(const Json& j, Scene& scene) {
-    j.at("sceneData").get_to(scene.sceneData);
+    // "sceneData" is derived from the spheres and meshes, it is only saved for reference
     j.at("spheres").get_to(scene.spheres);
-    // TODO load meshes; triangles; bvhNodes;
+
+    scene.ClearMeshes();
+    if (j.contains("meshes")) {
+        for (const auto& mesh : j.at("meshes")) {
+            // A scene without one of its meshes would still render, a failed load has to be reported
+            const auto path = mesh.at("path").get<std::string>();
+            if (!scene.AddMesh(path, mesh.at("material").get<Material>())) {
+                throw Json::other_error::create(599, "failed to load mesh " + path, &mesh);
+            }
+        }
+    }
 }
 
 // ---- Camera ----
@@ -165,15 +185,79 @@ void from_json(const Json& j, Camera& camera) {
     j.at("fovDeg").get_to(camera.fovDeg);
 }
 
+// ---- CameraPath ----
+void to_json(Json& j, const CameraPath& cameraPath) {
+    j = Json{
+        {"keyframes", cameraPath.keyframes},
+    };
+}
+
+void from_json(const Json& j, CameraPath& cameraPath) {
+    j.at("keyframes").get_to(cameraPath.keyframes);
+}
+
+// ---- RenderSettings ----
+void to_json(Json& j, const RenderSettings& settings) {
+    j = Json{
+        {"integrator", ToString(settings.integrator)},
+        {"maxBounces", settings.maxBounces},
+        {"sortRays", settings.sortRays},
+        {"russianRoulette", settings.russianRoulette},
+        {"rouletteMinDepth", settings.rouletteMinDepth},
+        {"lightSampling", settings.lightSampling},
+        {"sampleSequence", ToString(settings.sampleSequence)},
+        {"samplesPerDispatch", settings.samplesPerDispatch},
+        {"frameBudgetMs", settings.frameBudgetMs},
+        {"maxSamples", settings.maxSamples},
+        {"adaptiveSampling", settings.adaptiveSampling},
+        {"adaptiveThreshold", settings.adaptiveThreshold},
+        {"adaptiveMinSamples", settings.adaptiveMinSamples},
+        {"toneMapping", settings.toneMapping},
+        {"tileBudgetMs", settings.tileBudgetMs},
+        {"tileOrder", ToString(settings.tileOrder)},
+        {"motionFrameMs", settings.motionFrameMs},
+    };
+}
+
+void from_json(const Json& j, RenderSettings& settings) {
+    // Every field is optional: scenes saved before a setting existed keep its default
+    if (j.contains("integrator")) {
+        settings.integrator = ParseIntegrator(j.at("integrator").get<std::string>()).value_or(settings.integrator);
+    }
+    settings.maxBounces = j.value("maxBounces", settings.maxBounces);
+    settings.sortRays = j.value("sortRays", settings.sortRays);
+    settings.russianRoulette = j.value("russianRoulette", settings.russianRoulette);
+    settings.rouletteMinDepth = j.value("rouletteMinDepth", settings.rouletteMinDepth);
+    settings.lightSampling = j.value("lightSampling", settings.lightSampling);
+    if (j.contains("sampleSequence")) {
+        const auto sequence = ParseSampleSequence(j.at("sampleSequence").get<std::string>());
+        settings.sampleSequence = sequence.value_or(settings.sampleSequence);
+    }
+    settings.samplesPerDispatch = j.value("samplesPerDispatch", settings.samplesPerDispatch);
+    settings.frameBudgetMs = j.value("frameBudgetMs", settings.frameBudgetMs);
+    settings.maxSamples = j.value("maxSamples", settings.maxSamples);
+    settings.adaptiveSampling = j.value("adaptiveSampling", settings.adaptiveSampling);
+    settings.adaptiveThreshold = j.value("adaptiveThreshold", settings.adaptiveThreshold);
+    settings.adaptiveMinSamples = j.value("adaptiveMinSamples", settings.adaptiveMinSamples);
+    settings.toneMapping = j.value("toneMapping", settings.toneMapping);
+    settings.tileBudgetMs = j.value("tileBudgetMs", settings.tileBudgetMs);
+    if (j.contains("tileOrder")) {
+        settings.tileOrder = ParseTileOrder(j.at("tileOrder").get<std::string>()).value_or(settings.tileOrder);
+    }
+    settings.motionFrameMs = j.value("motionFrameMs", settings.motionFrameMs);
+}
+
 // ---- Raytracer ----
 void to_json(Json& j, const Raytracer& raytracer) {
     j = Json{
         {"camera", raytracer.camera},
         {"scene", raytracer.scene},
+        {"settings", raytracer.settings},
     };
 }
 
 void from_json(const Json& j, Raytracer& raytracer) {
     j.at("camera").get_to(raytracer.camera);
     j.at("scene").get_to(raytracer.scene);
+    if (j.contains("settings")) j.at("settings").get_to(raytracer.settings);
 }
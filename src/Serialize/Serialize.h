@@ -4,6 +4,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include "Raytracer/CameraPath.h"
 #include "Raytracer/Raytracer.h"
 #include "Raytracer/Scene.h"
 using Json = nlohmann::json;
@@ -54,6 +55,14 @@ void from_json(const Json& j, Scene& scene);
 void to_json(Json& j, const Camera& camera);
 void from_json(const Json& j, Camera& camera);
 
+// ---- CameraPath ----
+void to_json(Json& j, const CameraPath& cameraPath);
+void from_json(const Json& j, CameraPath& cameraPath);
+
+// ---- RenderSettings ----
+void to_json(Json& j, const RenderSettings& settings);
+void from_json(const Json& j, RenderSettings& settings);
+
 // ---- Raytracer ----
 void to_json(Json& j, const Raytracer& raytracer);
 void from_json(const Json& j, Raytracer& raytracer);
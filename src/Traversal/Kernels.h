@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Traversal.h"
+
+// Entry points of the per-ISA translation units. Each one is compiled with its own instruction set flags,
+// so they only share plain data: an inline function instantiated there could be picked by the linker for
+// every caller, AVX2 encoding included.
+namespace Traversal {
+    namespace Scalar {
+        void Intersect(const WideBVH& bvh, const Ray& ray, Hit& hit);
+    }
+
+#ifdef RAYTRACER_X86_SIMD
+    namespace SSE41 {
+        void Intersect(const WideBVH& bvh, const Ray& ray, Hit& hit);
+        void IntersectPacket(const WideBVH& bvh, const Ray* rays, Hit* hits, uint32_t count);
+    }
+
+    namespace AVX2 {
+        void IntersectPacket(const WideBVH& bvh, const Ray* rays, Hit* hits, uint32_t count);
+    }
+#endif
+
+    // Traversal stack per ray or packet, enough for a wide tree collapsed from the 32-entry GPU stack
+    constexpr uint32_t STACK_SIZE = 64;
+
+    // RayTriangleIntersection() of main.comp for a single ray, dst is updated on a closer hit.
+    // Static on purpose: every translation unit gets its own copy, compiled with its own flags.
+    [[maybe_unused]] static bool IntersectTriangle(const TriangleData& t,
+                                                   const float ori[3],
+                                                   const float dir[3],
+                                                   float& dst) {
+        const float ao[3] = {ori[0] - t.a[0], ori[1] - t.a[1], ori[2] - t.a[2]};
+        const float dao[3] = {
+            ao[1] * dir[2] - ao[2] * dir[1],
+            ao[2] * dir[0] - ao[0] * dir[2],
+            ao[0] * dir[1] - ao[1] * dir[0],
+        };
+
+        const float determinant = -(dir[0] * t.normal[0] + dir[1] * t.normal[1] + dir[2] * t.normal[2]);
+        const float invDet = 1.0f / determinant;
+
+        const float d = (ao[0] * t.normal[0] + ao[1] * t.normal[1] + ao[2] * t.normal[2]) * invDet;
+        const float u = (t.ac[0] * dao[0] + t.ac[1] * dao[1] + t.ac[2] * dao[2]) * invDet;
+        const float v = -(t.ab[0] * dao[0] + t.ab[1] * dao[1] + t.ab[2] * dao[2]) * invDet;
+        const float w = 1.0f - u - v;
+
+        if (!(determinant >= 1e-6f && d >= 0.0f && u >= 0.0f && v >= 0.0f && w >= 0.0f && d < dst)) return false;
+        dst = d;
+        return true;
+    }
+}
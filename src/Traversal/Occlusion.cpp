@@ -0,0 +1,73 @@
+#include "Traversal.h"
+
+#include <algorithm>
+
+namespace {
+    // Enough for the deepest flattened tree the GPU kernels are specialized for
+    constexpr uint32_t STACK_SIZE = 64;
+
+    // RayTriangleOccludes() of common.glsl
+    bool TriangleOccludes(const Traversal::Ray& ray, const Triangle& triangle, const float tMax) {
+        const glm::vec3 ab = triangle.b - triangle.a;
+        const glm::vec3 ac = triangle.c - triangle.a;
+        const glm::vec3 normal = glm::cross(ab, ac);
+
+        const float determinant = -glm::dot(ray.dir, normal);
+        if (determinant < 1e-6f) return false;
+
+        const glm::vec3 ao = ray.ori - triangle.a;
+        const float invDet = 1.0f / determinant;
+        const float dst = glm::dot(ao, normal) * invDet;
+        if (dst < 0.0f || dst >= tMax) return false;
+
+        const glm::vec3 dao = glm::cross(ao, ray.dir);
+        const float u = glm::dot(ac, dao) * invDet;
+        const float v = -glm::dot(ab, dao) * invDet;
+        return u >= 0.0f && v >= 0.0f && u + v <= 1.0f;
+    }
+
+    // RayBoundingBoxOverlaps() of common.glsl
+    bool BoxOverlaps(const glm::vec3& ori, const glm::vec3& invDir, const BoundingBox& bbox, const float tMax) {
+        const glm::vec3 tLow = (bbox.min - ori) * invDir;
+        const glm::vec3 tHigh = (bbox.max - ori) * invDir;
+        const glm::vec3 t1 = glm::min(tLow, tHigh);
+        const glm::vec3 t2 = glm::max(tLow, tHigh);
+        const float tNear = std::max({t1.x, t1.y, t1.z, 0.0f});
+        const float tFar = std::min({t2.x, t2.y, t2.z, tMax});
+
+        return tNear <= tFar;
+    }
+}
+
+namespace Traversal {
+    bool Occluded(const std::span<const BVH_FlattenNode> nodes,
+                  const std::span<const Triangle> triangles,
+                  const std::span<const Mesh> meshes,
+                  const Ray& ray,
+                  const float tMax) {
+        const glm::vec3 invDir = 1.0f / ray.dir;
+
+        for (const Mesh& mesh : meshes) {
+            uint32_t stack[STACK_SIZE];
+            uint32_t stackTopIndex = 0;
+            stack[stackTopIndex++] = mesh.start;
+
+            while (stackTopIndex != 0) {
+                // Leaves are culled as well, a box test is cheaper than the triangles it holds
+                const BVH_FlattenNode& node = nodes[stack[--stackTopIndex]];
+                if (!BoxOverlaps(ray.ori, invDir, node.bbox, tMax)) continue;
+
+                if (node.left == 0 && node.right == 0) {
+                    for (uint32_t t = node.start; t < node.start + node.count; ++t) {
+                        if (TriangleOccludes(ray, triangles[t], tMax)) return true;
+                    }
+                } else {
+                    stack[stackTopIndex++] = node.left;
+                    stack[stackTopIndex++] = node.right;
+                }
+            }
+        }
+
+        return false;
+    }
+}
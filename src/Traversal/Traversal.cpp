@@ -0,0 +1,133 @@
+#include "Traversal.h"
+
+#include "Kernels.h"
+
+#include <algorithm>
+
+#include "Core/Log.h"
+
+#if defined(RAYTRACER_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+#ifdef RAYTRACER_X86_SIMD
+#ifdef _MSC_VER
+    bool HasSSE41() {
+        int info[4];
+        __cpuid(info, 1);
+        return info[2] & 1 << 19;
+    }
+
+    bool HasAVX2() {
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = info[2] & 1 << 27;
+        const bool avx = info[2] & 1 << 28;
+        if (!osxsave || !avx) return false;
+
+        // The OS must save the YMM registers on context switches
+        if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+        __cpuidex(info, 7, 0);
+        return info[1] & 1 << 5;
+    }
+#else
+    bool HasSSE41() {
+        return __builtin_cpu_supports("sse4.1");
+    }
+
+    // Also checks the OS support for the YMM state
+    bool HasAVX2() {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+#endif
+}
+
+namespace Traversal {
+    const char* ToString(const Isa isa) {
+        switch (isa) {
+        case Isa::Scalar:
+            return "Scalar";
+        case Isa::SSE41:
+            return "SSE4.1";
+        case Isa::AVX2:
+            return "AVX2";
+        }
+        return "Unknown";
+    }
+
+    bool IsSupported(const Isa isa) {
+        switch (isa) {
+        case Isa::Scalar:
+            return true;
+#ifdef RAYTRACER_X86_SIMD
+        case Isa::SSE41:
+            return HasSSE41();
+        case Isa::AVX2:
+            return HasSSE41() && HasAVX2();
+#endif
+        default:
+            return false;
+        }
+    }
+
+    Isa DetectIsa() {
+        if (IsSupported(Isa::AVX2)) return Isa::AVX2;
+        if (IsSupported(Isa::SSE41)) return Isa::SSE41;
+        return Isa::Scalar;
+    }
+
+    Engine::Engine(const std::span<const BVH_FlattenNode> nodes,
+                   const std::span<const Triangle> triangles,
+                   const std::span<const Mesh> meshes,
+                   const Isa isa) : bvh(WideBVH::Build(nodes, triangles, meshes)), isa(isa) {
+        if (!IsSupported(isa)) {
+            this->isa = DetectIsa();
+            LOGW("{} traversal is not supported on this CPU, using {}", ToString(isa), ToString(this->isa));
+        }
+    }
+
+    void Engine::Intersect(const Ray& ray, Hit& hit) const {
+        switch (isa) {
+#ifdef RAYTRACER_X86_SIMD
+        // Eight lanes would leave half of them idle on a four-wide node
+        case Isa::SSE41:
+        case Isa::AVX2:
+            SSE41::Intersect(bvh, ray, hit);
+            return;
+#endif
+        default:
+            Scalar::Intersect(bvh, ray, hit);
+        }
+    }
+
+    void Engine::Intersect(const std::span<const Ray> rays, const std::span<Hit> hits) const {
+        const auto count = static_cast<uint32_t>(std::min(rays.size(), hits.size()));
+
+        switch (isa) {
+#ifdef RAYTRACER_X86_SIMD
+        case Isa::SSE41:
+            SSE41::IntersectPacket(bvh, rays.data(), hits.data(), count);
+            return;
+        case Isa::AVX2:
+            AVX2::IntersectPacket(bvh, rays.data(), hits.data(), count);
+            return;
+#endif
+        default:
+            for (uint32_t i = 0; i < count; ++i) Scalar::Intersect(bvh, rays[i], hits[i]);
+        }
+    }
+
+    uint32_t Engine::GetPacketWidth() const {
+        switch (isa) {
+        case Isa::SSE41:
+            return 4;
+        case Isa::AVX2:
+            return 8;
+        default:
+            return 1;
+        }
+    }
+}
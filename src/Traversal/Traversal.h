@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cfloat>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "WideBVH.h"
+
+// Closest-hit queries over the scene meshes on the CPU, with SIMD kernels selected at runtime.
+// Hits follow main.comp: back faces are culled and spheres are left to the caller.
+namespace Traversal {
+    enum class Isa {
+        Scalar,
+        SSE41, // 4-wide packets
+        AVX2,  // 8-wide packets
+    };
+
+    const char* ToString(Isa isa);
+
+    // Compiled in and supported by the CPU (and the OS, for the AVX register state)
+    bool IsSupported(Isa isa);
+    Isa DetectIsa();
+
+    struct Ray {
+        glm::vec3 ori;
+        glm::vec3 dir;
+    };
+
+    struct Hit {
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        float dst = FLT_MAX;
+        uint32_t triangle = NONE;
+        uint32_t mesh = NONE;
+
+        bool DidHit() const { return triangle != NONE; }
+    };
+
+    class Engine {
+    public:
+        Engine(std::span<const BVH_FlattenNode> nodes,
+               std::span<const Triangle> triangles,
+               std::span<const Mesh> meshes,
+               Isa isa = DetectIsa());
+
+        // Single ray, children of a wide node are tested together: for incoherent bounces
+        void Intersect(const Ray& ray, Hit& hit) const;
+
+        // Packets of GetPacketWidth() consecutive rays share the traversal: for coherent primary rays.
+        // hits must be as large as rays, existing distances bound the search.
+        void Intersect(std::span<const Ray> rays, std::span<Hit> hits) const;
+
+        Isa GetIsa() const { return isa; }
+        uint32_t GetPacketWidth() const;
+        const WideBVH& GetBVH() const { return bvh; }
+
+    private:
+        WideBVH bvh;
+        Isa isa;
+    };
+
+    // Any-hit query over the flattened binary BVH of Scene, the C++ side of Occluded() in common.glsl:
+    // true as soon as a front-facing triangle lies closer than tMax. No build step, for shadow and AO rays.
+    bool Occluded(std::span<const BVH_FlattenNode> nodes,
+                  std::span<const Triangle> triangles,
+                  std::span<const Mesh> meshes,
+                  const Ray& ray,
+                  float tMax);
+}
@@ -0,0 +1,144 @@
+#include "Kernels.h"
+
+#include <immintrin.h>
+
+namespace {
+    // Internal linkage keeps these helpers, and their AVX2 encoding, private to this translation unit
+    __m256 Min3(const __m256 a, const __m256 b, const __m256 c) { return _mm256_min_ps(_mm256_min_ps(a, b), c); }
+    __m256 Max3(const __m256 a, const __m256 b, const __m256 c) { return _mm256_max_ps(_mm256_max_ps(a, b), c); }
+
+    // Ordered comparisons, false on NaN like the SSE predicates
+    __m256 Le(const __m256 a, const __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    __m256 Ge(const __m256 a, const __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    __m256 Lt(const __m256 a, const __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+
+    // Dot product of a triangle vector, broadcast, with a vector of the packet
+    __m256 Dot(const float v[3], const __m256 x, const __m256 y, const __m256 z) {
+        const __m256 xy = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(v[0]), x), _mm256_mul_ps(_mm256_set1_ps(v[1]), y));
+        return _mm256_add_ps(xy, _mm256_mul_ps(_mm256_set1_ps(v[2]), z));
+    }
+}
+
+namespace Traversal::AVX2 {
+    void IntersectPacket(const WideBVH& bvh, const Ray* rays, Hit* hits, const uint32_t count) {
+        constexpr uint32_t WIDTH = 8;
+
+        for (uint32_t first = 0; first < count; first += WIDTH) {
+            const uint32_t lanes = count - first < WIDTH ? count - first : WIDTH;
+
+            // Inactive lanes replay the first ray, their results are discarded
+            alignas(32) float o[3][WIDTH], d[3][WIDTH], closestInit[WIDTH];
+            alignas(32) int32_t activeInit[WIDTH], triangleInit[WIDTH], meshInit[WIDTH];
+            for (uint32_t lane = 0; lane < WIDTH; ++lane) {
+                const uint32_t r = first + (lane < lanes ? lane : 0);
+                o[0][lane] = rays[r].ori.x;
+                o[1][lane] = rays[r].ori.y;
+                o[2][lane] = rays[r].ori.z;
+                d[0][lane] = rays[r].dir.x;
+                d[1][lane] = rays[r].dir.y;
+                d[2][lane] = rays[r].dir.z;
+                closestInit[lane] = hits[r].dst;
+                triangleInit[lane] = static_cast<int32_t>(hits[r].triangle);
+                meshInit[lane] = static_cast<int32_t>(hits[r].mesh);
+                activeInit[lane] = lane < lanes ? -1 : 0;
+            }
+
+            const __m256 ox = _mm256_load_ps(o[0]), oy = _mm256_load_ps(o[1]), oz = _mm256_load_ps(o[2]);
+            const __m256 dx = _mm256_load_ps(d[0]), dy = _mm256_load_ps(d[1]), dz = _mm256_load_ps(d[2]);
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 ix = _mm256_div_ps(one, dx), iy = _mm256_div_ps(one, dy), iz = _mm256_div_ps(one, dz);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 epsilon = _mm256_set1_ps(1e-6f);
+            const __m256 active = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(activeInit)));
+
+            __m256 closest = _mm256_load_ps(closestInit);
+            __m256 triangle = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(triangleInit)));
+            __m256 meshHit = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(meshInit)));
+
+            for (uint32_t mesh = 0; mesh < bvh.roots.size(); ++mesh) {
+                const __m256 meshIndex = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int32_t>(mesh)));
+
+                uint32_t stack[STACK_SIZE];
+                uint32_t stackTopIndex = 0;
+                stack[stackTopIndex++] = bvh.roots[mesh];
+
+                while (stackTopIndex != 0) {
+                    const WideNode& node = bvh.nodes[stack[--stackTopIndex]];
+
+                    for (uint32_t slot = 0; slot < 4; ++slot) {
+                        if (node.count[slot] == 0) continue;
+
+                        // One child against every ray of the packet
+                        const __m256 tx0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.minX[slot]), ox), ix);
+                        const __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.maxX[slot]), ox), ix);
+                        const __m256 ty0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.minY[slot]), oy), iy);
+                        const __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.maxY[slot]), oy), iy);
+                        const __m256 tz0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.minZ[slot]), oz), iz);
+                        const __m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.maxZ[slot]), oz), iz);
+
+                        const __m256 tNear = Max3(_mm256_min_ps(tx0, tx1),
+                                                  _mm256_min_ps(ty0, ty1),
+                                                  _mm256_min_ps(tz0, tz1));
+                        const __m256 tFar = Min3(_mm256_max_ps(tx0, tx1),
+                                                 _mm256_max_ps(ty0, ty1),
+                                                 _mm256_max_ps(tz0, tz1));
+
+                        __m256 boxMask = _mm256_and_ps(Le(tNear, tFar), Ge(tFar, zero));
+                        boxMask = _mm256_and_ps(boxMask, _mm256_and_ps(Le(tNear, closest), active));
+                        if (!_mm256_movemask_ps(boxMask)) continue;
+
+                        if (node.count[slot] == WideNode::INNER) {
+                            stack[stackTopIndex++] = node.child[slot];
+                            continue;
+                        }
+
+                        const uint32_t end = node.child[slot] + node.count[slot];
+                        for (uint32_t t = node.child[slot]; t < end; ++t) {
+                            const TriangleData& tri = bvh.triangles[t];
+
+                            const __m256 aox = _mm256_sub_ps(ox, _mm256_set1_ps(tri.a[0]));
+                            const __m256 aoy = _mm256_sub_ps(oy, _mm256_set1_ps(tri.a[1]));
+                            const __m256 aoz = _mm256_sub_ps(oz, _mm256_set1_ps(tri.a[2]));
+
+                            const __m256 daox = _mm256_sub_ps(_mm256_mul_ps(aoy, dz), _mm256_mul_ps(aoz, dy));
+                            const __m256 daoy = _mm256_sub_ps(_mm256_mul_ps(aoz, dx), _mm256_mul_ps(aox, dz));
+                            const __m256 daoz = _mm256_sub_ps(_mm256_mul_ps(aox, dy), _mm256_mul_ps(aoy, dx));
+
+                            const __m256 determinant = _mm256_sub_ps(zero, Dot(tri.normal, dx, dy, dz));
+                            const __m256 invDet = _mm256_div_ps(one, determinant);
+
+                            const __m256 dst = _mm256_mul_ps(Dot(tri.normal, aox, aoy, aoz), invDet);
+                            const __m256 u = _mm256_mul_ps(Dot(tri.ac, daox, daoy, daoz), invDet);
+                            const __m256 v = _mm256_sub_ps(zero, _mm256_mul_ps(Dot(tri.ab, daox, daoy, daoz), invDet));
+                            const __m256 w = _mm256_sub_ps(_mm256_sub_ps(one, u), v);
+
+                            __m256 hitMask = _mm256_and_ps(Ge(determinant, epsilon), Ge(dst, zero));
+                            hitMask = _mm256_and_ps(hitMask, Ge(u, zero));
+                            hitMask = _mm256_and_ps(hitMask, Ge(v, zero));
+                            hitMask = _mm256_and_ps(hitMask, Ge(w, zero));
+                            hitMask = _mm256_and_ps(hitMask, Lt(dst, closest));
+                            hitMask = _mm256_and_ps(hitMask, active);
+
+                            const __m256i index = _mm256_set1_epi32(static_cast<int32_t>(t));
+                            const __m256 triangleIndex = _mm256_castsi256_ps(index);
+                            closest = _mm256_blendv_ps(closest, dst, hitMask);
+                            triangle = _mm256_blendv_ps(triangle, triangleIndex, hitMask);
+                            meshHit = _mm256_blendv_ps(meshHit, meshIndex, hitMask);
+                        }
+                    }
+                }
+            }
+
+            alignas(32) float closestOut[WIDTH];
+            alignas(32) int32_t triangleOut[WIDTH], meshOut[WIDTH];
+            _mm256_store_ps(closestOut, closest);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(triangleOut), _mm256_castps_si256(triangle));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(meshOut), _mm256_castps_si256(meshHit));
+            for (uint32_t lane = 0; lane < lanes; ++lane) {
+                hits[first + lane].dst = closestOut[lane];
+                hits[first + lane].triangle = static_cast<uint32_t>(triangleOut[lane]);
+                hits[first + lane].mesh = static_cast<uint32_t>(meshOut[lane]);
+            }
+        }
+    }
+}
@@ -0,0 +1,207 @@
+#include "Kernels.h"
+
+#include <smmintrin.h>
+
+namespace {
+    // Internal linkage keeps these helpers, and their SSE4.1 encoding, private to this translation unit
+    __m128 Min3(const __m128 a, const __m128 b, const __m128 c) { return _mm_min_ps(_mm_min_ps(a, b), c); }
+    __m128 Max3(const __m128 a, const __m128 b, const __m128 c) { return _mm_max_ps(_mm_max_ps(a, b), c); }
+
+    // Dot product of a triangle vector, broadcast, with a vector of the packet
+    __m128 Dot(const float v[3], const __m128 x, const __m128 y, const __m128 z) {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), x), _mm_mul_ps(_mm_set1_ps(v[1]), y)),
+                          _mm_mul_ps(_mm_set1_ps(v[2]), z));
+    }
+}
+
+namespace Traversal::SSE41 {
+    void Intersect(const WideBVH& bvh, const Ray& ray, Hit& hit) {
+        const float ori[3] = {ray.ori.x, ray.ori.y, ray.ori.z};
+        const float dir[3] = {ray.dir.x, ray.dir.y, ray.dir.z};
+
+        const __m128 ox = _mm_set1_ps(ori[0]);
+        const __m128 oy = _mm_set1_ps(ori[1]);
+        const __m128 oz = _mm_set1_ps(ori[2]);
+        const __m128 ix = _mm_set1_ps(1.0f / dir[0]);
+        const __m128 iy = _mm_set1_ps(1.0f / dir[1]);
+        const __m128 iz = _mm_set1_ps(1.0f / dir[2]);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (uint32_t mesh = 0; mesh < bvh.roots.size(); ++mesh) {
+            uint32_t stack[STACK_SIZE];
+            uint32_t stackTopIndex = 0;
+            stack[stackTopIndex++] = bvh.roots[mesh];
+
+            while (stackTopIndex != 0) {
+                const WideNode& node = bvh.nodes[stack[--stackTopIndex]];
+
+                // The four children at once
+                const __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), ox), ix);
+                const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), ox), ix);
+                const __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), oy), iy);
+                const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), oy), iy);
+                const __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), oz), iz);
+                const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), oz), iz);
+
+                const __m128 tNear = Max3(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1), _mm_min_ps(tz0, tz1));
+                const __m128 tFar = Min3(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1), _mm_max_ps(tz0, tz1));
+
+                __m128 mask = _mm_and_ps(_mm_cmple_ps(tNear, tFar), _mm_cmpge_ps(tFar, zero));
+                mask = _mm_and_ps(mask, _mm_cmple_ps(tNear, _mm_set1_ps(hit.dst)));
+                const int bits = _mm_movemask_ps(mask);
+                if (!bits) continue;
+
+                alignas(16) float near[4];
+                _mm_store_ps(near, tNear);
+
+                // Leaves are tested right away to shrink the closest distance, inner children are pushed far
+                // to near so the nearest is popped first
+                uint32_t inner[4];
+                float innerNear[4];
+                uint32_t innerCount = 0;
+
+                for (uint32_t slot = 0; slot < 4; ++slot) {
+                    if (!(bits & 1 << slot) || node.count[slot] == 0) continue;
+
+                    if (node.count[slot] == WideNode::INNER) {
+                        uint32_t i = innerCount++;
+                        for (; i > 0 && innerNear[i - 1] < near[slot]; --i) {
+                            inner[i] = inner[i - 1];
+                            innerNear[i] = innerNear[i - 1];
+                        }
+                        inner[i] = node.child[slot];
+                        innerNear[i] = near[slot];
+                        continue;
+                    }
+
+                    const uint32_t end = node.child[slot] + node.count[slot];
+                    for (uint32_t t = node.child[slot]; t < end; ++t) {
+                        if (IntersectTriangle(bvh.triangles[t], ori, dir, hit.dst)) {
+                            hit.triangle = t;
+                            hit.mesh = mesh;
+                        }
+                    }
+                }
+
+                for (uint32_t i = 0; i < innerCount; ++i) stack[stackTopIndex++] = inner[i];
+            }
+        }
+    }
+
+    void IntersectPacket(const WideBVH& bvh, const Ray* rays, Hit* hits, const uint32_t count) {
+        constexpr uint32_t WIDTH = 4;
+
+        for (uint32_t first = 0; first < count; first += WIDTH) {
+            const uint32_t lanes = count - first < WIDTH ? count - first : WIDTH;
+
+            // Inactive lanes replay the first ray, their results are discarded
+            alignas(16) float o[3][WIDTH], d[3][WIDTH], closestInit[WIDTH];
+            alignas(16) int32_t activeInit[WIDTH], triangleInit[WIDTH], meshInit[WIDTH];
+            for (uint32_t lane = 0; lane < WIDTH; ++lane) {
+                const uint32_t r = first + (lane < lanes ? lane : 0);
+                o[0][lane] = rays[r].ori.x;
+                o[1][lane] = rays[r].ori.y;
+                o[2][lane] = rays[r].ori.z;
+                d[0][lane] = rays[r].dir.x;
+                d[1][lane] = rays[r].dir.y;
+                d[2][lane] = rays[r].dir.z;
+                closestInit[lane] = hits[r].dst;
+                triangleInit[lane] = static_cast<int32_t>(hits[r].triangle);
+                meshInit[lane] = static_cast<int32_t>(hits[r].mesh);
+                activeInit[lane] = lane < lanes ? -1 : 0;
+            }
+
+            const __m128 ox = _mm_load_ps(o[0]), oy = _mm_load_ps(o[1]), oz = _mm_load_ps(o[2]);
+            const __m128 dx = _mm_load_ps(d[0]), dy = _mm_load_ps(d[1]), dz = _mm_load_ps(d[2]);
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 ix = _mm_div_ps(one, dx), iy = _mm_div_ps(one, dy), iz = _mm_div_ps(one, dz);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 epsilon = _mm_set1_ps(1e-6f);
+            const __m128 active = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(activeInit)));
+
+            __m128 closest = _mm_load_ps(closestInit);
+            __m128 triangle = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(triangleInit)));
+            __m128 meshHit = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(meshInit)));
+
+            for (uint32_t mesh = 0; mesh < bvh.roots.size(); ++mesh) {
+                const __m128 meshIndex = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(mesh)));
+
+                uint32_t stack[STACK_SIZE];
+                uint32_t stackTopIndex = 0;
+                stack[stackTopIndex++] = bvh.roots[mesh];
+
+                while (stackTopIndex != 0) {
+                    const WideNode& node = bvh.nodes[stack[--stackTopIndex]];
+
+                    for (uint32_t slot = 0; slot < 4; ++slot) {
+                        if (node.count[slot] == 0) continue;
+
+                        // One child against every ray of the packet
+                        const __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minX[slot]), ox), ix);
+                        const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxX[slot]), ox), ix);
+                        const __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minY[slot]), oy), iy);
+                        const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxY[slot]), oy), iy);
+                        const __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.minZ[slot]), oz), iz);
+                        const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.maxZ[slot]), oz), iz);
+
+                        const __m128 tNear = Max3(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1), _mm_min_ps(tz0, tz1));
+                        const __m128 tFar = Min3(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1), _mm_max_ps(tz0, tz1));
+
+                        __m128 boxMask = _mm_and_ps(_mm_cmple_ps(tNear, tFar), _mm_cmpge_ps(tFar, zero));
+                        boxMask = _mm_and_ps(boxMask, _mm_and_ps(_mm_cmple_ps(tNear, closest), active));
+                        if (!_mm_movemask_ps(boxMask)) continue;
+
+                        if (node.count[slot] == WideNode::INNER) {
+                            stack[stackTopIndex++] = node.child[slot];
+                            continue;
+                        }
+
+                        const uint32_t end = node.child[slot] + node.count[slot];
+                        for (uint32_t t = node.child[slot]; t < end; ++t) {
+                            const TriangleData& tri = bvh.triangles[t];
+
+                            const __m128 aox = _mm_sub_ps(ox, _mm_set1_ps(tri.a[0]));
+                            const __m128 aoy = _mm_sub_ps(oy, _mm_set1_ps(tri.a[1]));
+                            const __m128 aoz = _mm_sub_ps(oz, _mm_set1_ps(tri.a[2]));
+
+                            const __m128 daox = _mm_sub_ps(_mm_mul_ps(aoy, dz), _mm_mul_ps(aoz, dy));
+                            const __m128 daoy = _mm_sub_ps(_mm_mul_ps(aoz, dx), _mm_mul_ps(aox, dz));
+                            const __m128 daoz = _mm_sub_ps(_mm_mul_ps(aox, dy), _mm_mul_ps(aoy, dx));
+
+                            const __m128 determinant = _mm_sub_ps(zero, Dot(tri.normal, dx, dy, dz));
+                            const __m128 invDet = _mm_div_ps(one, determinant);
+
+                            const __m128 dst = _mm_mul_ps(Dot(tri.normal, aox, aoy, aoz), invDet);
+                            const __m128 u = _mm_mul_ps(Dot(tri.ac, daox, daoy, daoz), invDet);
+                            const __m128 v = _mm_sub_ps(zero, _mm_mul_ps(Dot(tri.ab, daox, daoy, daoz), invDet));
+                            const __m128 w = _mm_sub_ps(_mm_sub_ps(one, u), v);
+
+                            __m128 hitMask = _mm_and_ps(_mm_cmpge_ps(determinant, epsilon), _mm_cmpge_ps(dst, zero));
+                            hitMask = _mm_and_ps(hitMask, _mm_cmpge_ps(u, zero));
+                            hitMask = _mm_and_ps(hitMask, _mm_cmpge_ps(v, zero));
+                            hitMask = _mm_and_ps(hitMask, _mm_cmpge_ps(w, zero));
+                            hitMask = _mm_and_ps(hitMask, _mm_cmplt_ps(dst, closest));
+                            hitMask = _mm_and_ps(hitMask, active);
+
+                            const __m128 triangleIndex = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(t)));
+                            closest = _mm_blendv_ps(closest, dst, hitMask);
+                            triangle = _mm_blendv_ps(triangle, triangleIndex, hitMask);
+                            meshHit = _mm_blendv_ps(meshHit, meshIndex, hitMask);
+                        }
+                    }
+                }
+            }
+
+            alignas(16) float closestOut[WIDTH];
+            alignas(16) int32_t triangleOut[WIDTH], meshOut[WIDTH];
+            _mm_store_ps(closestOut, closest);
+            _mm_store_si128(reinterpret_cast<__m128i*>(triangleOut), _mm_castps_si128(triangle));
+            _mm_store_si128(reinterpret_cast<__m128i*>(meshOut), _mm_castps_si128(meshHit));
+            for (uint32_t lane = 0; lane < lanes; ++lane) {
+                hits[first + lane].dst = closestOut[lane];
+                hits[first + lane].triangle = static_cast<uint32_t>(triangleOut[lane]);
+                hits[first + lane].mesh = static_cast<uint32_t>(meshOut[lane]);
+            }
+        }
+    }
+}
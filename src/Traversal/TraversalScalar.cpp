@@ -0,0 +1,49 @@
+#include "Kernels.h"
+
+#include <algorithm>
+
+namespace Traversal::Scalar {
+    void Intersect(const WideBVH& bvh, const Ray& ray, Hit& hit) {
+        const float ori[3] = {ray.ori.x, ray.ori.y, ray.ori.z};
+        const float dir[3] = {ray.dir.x, ray.dir.y, ray.dir.z};
+        const float invDir[3] = {1.0f / dir[0], 1.0f / dir[1], 1.0f / dir[2]};
+
+        for (uint32_t mesh = 0; mesh < bvh.roots.size(); ++mesh) {
+            uint32_t stack[STACK_SIZE];
+            uint32_t stackTopIndex = 0;
+            stack[stackTopIndex++] = bvh.roots[mesh];
+
+            while (stackTopIndex != 0) {
+                const WideNode& node = bvh.nodes[stack[--stackTopIndex]];
+
+                for (uint32_t slot = 0; slot < 4; ++slot) {
+                    if (node.count[slot] == 0) continue;
+
+                    // Same slab test as main.comp, also culling boxes behind the ray or past the closest hit
+                    const float tx0 = (node.minX[slot] - ori[0]) * invDir[0];
+                    const float tx1 = (node.maxX[slot] - ori[0]) * invDir[0];
+                    const float ty0 = (node.minY[slot] - ori[1]) * invDir[1];
+                    const float ty1 = (node.maxY[slot] - ori[1]) * invDir[1];
+                    const float tz0 = (node.minZ[slot] - ori[2]) * invDir[2];
+                    const float tz1 = (node.maxZ[slot] - ori[2]) * invDir[2];
+                    const float tNear = std::max({std::min(tx0, tx1), std::min(ty0, ty1), std::min(tz0, tz1)});
+                    const float tFar = std::min({std::max(tx0, tx1), std::max(ty0, ty1), std::max(tz0, tz1)});
+                    if (!(tNear <= tFar && tFar >= 0.0f && tNear <= hit.dst)) continue;
+
+                    if (node.count[slot] == WideNode::INNER) {
+                        stack[stackTopIndex++] = node.child[slot];
+                        continue;
+                    }
+
+                    const uint32_t end = node.child[slot] + node.count[slot];
+                    for (uint32_t t = node.child[slot]; t < end; ++t) {
+                        if (IntersectTriangle(bvh.triangles[t], ori, dir, hit.dst)) {
+                            hit.triangle = t;
+                            hit.mesh = mesh;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include "WideBVH.h"
+
+#include <glm/glm.hpp>
+
+namespace {
+    using namespace Traversal;
+
+    bool IsLeaf(const BVH_FlattenNode& node) {
+        return node.left == 0 && node.right == 0;
+    }
+
+    float SurfaceArea(const BoundingBox& bbox) {
+        const glm::vec3 d = bbox.max - bbox.min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    uint32_t Collapse(const std::span<const BVH_FlattenNode> binary, const uint32_t index, std::vector<WideNode>& wide) {
+        // Open the largest inner child until four children are gathered, a leaf root is its own child
+        std::vector<uint32_t> children;
+        if (IsLeaf(binary[index])) children = {index};
+        else children = {binary[index].left, binary[index].right};
+
+        while (children.size() < 4) {
+            auto largest = children.end();
+            float largestArea = -1.0f;
+            for (auto it = children.begin(); it != children.end(); ++it) {
+                if (IsLeaf(binary[*it])) continue;
+                const float area = SurfaceArea(binary[*it].bbox);
+                if (area > largestArea) {
+                    largestArea = area;
+                    largest = it;
+                }
+            }
+            if (largest == children.end()) break;
+
+            const BVH_FlattenNode& opened = binary[*largest];
+            *largest = opened.left;
+            children.push_back(opened.right);
+        }
+
+        const auto wideIndex = static_cast<uint32_t>(wide.size());
+        wide.emplace_back();
+
+        WideNode node{};
+        for (uint32_t slot = 0; slot < 4; ++slot) {
+            // Empty slots keep zero bounds, kernels skip them on their zero count
+            if (slot >= children.size()) continue;
+
+            const BVH_FlattenNode& child = binary[children[slot]];
+            node.minX[slot] = child.bbox.min.x;
+            node.minY[slot] = child.bbox.min.y;
+            node.minZ[slot] = child.bbox.min.z;
+            node.maxX[slot] = child.bbox.max.x;
+            node.maxY[slot] = child.bbox.max.y;
+            node.maxZ[slot] = child.bbox.max.z;
+
+            if (IsLeaf(child)) {
+                node.child[slot] = child.start;
+                node.count[slot] = child.count;
+            } else {
+                node.child[slot] = Collapse(binary, children[slot], wide);
+                node.count[slot] = WideNode::INNER;
+            }
+        }
+
+        wide[wideIndex] = node;
+        return wideIndex;
+    }
+}
+
+namespace Traversal {
+    WideBVH WideBVH::Build(const std::span<const BVH_FlattenNode> nodes,
+                           const std::span<const Triangle> triangles,
+                           const std::span<const Mesh> meshes) {
+        WideBVH bvh;
+
+        bvh.triangles.reserve(triangles.size());
+        for (const Triangle& t : triangles) {
+            const glm::vec3 ab = t.b - t.a;
+            const glm::vec3 ac = t.c - t.a;
+            const glm::vec3 normal = glm::cross(ab, ac);
+            bvh.triangles.push_back({
+                .a = {t.a.x, t.a.y, t.a.z},
+                .ab = {ab.x, ab.y, ab.z},
+                .ac = {ac.x, ac.y, ac.z},
+                .normal = {normal.x, normal.y, normal.z},
+            });
+        }
+
+        // A binary tree of n leaves collapses into at most n wide nodes
+        bvh.nodes.reserve(nodes.size() / 2 + meshes.size());
+        for (const Mesh& mesh : meshes) bvh.roots.push_back(Collapse(nodes, mesh.start, bvh.nodes));
+
+        return bvh;
+    }
+}
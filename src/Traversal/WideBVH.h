@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Raytracer/ComputeData.h"
+
+namespace Traversal {
+    // Four children per node, bounds stored per axis so that one ray tests them in a single SSE pass
+    struct alignas(16) WideNode {
+        static constexpr uint32_t INNER = UINT32_MAX;
+
+        float minX[4];
+        float minY[4];
+        float minZ[4];
+        float maxX[4];
+        float maxY[4];
+        float maxZ[4];
+
+        uint32_t child[4]; // WideNode index for inner children, first triangle for leaves
+        uint32_t count[4]; // Triangle count for leaves (0 for empty slots), INNER otherwise
+    };
+
+    // Edges and normal precomputed with the same operations as RayTriangleIntersection() in main.comp
+    struct TriangleData {
+        float a[3];
+        float ab[3];
+        float ac[3];
+        float normal[3];
+    };
+
+    // Collapses the binary BVH of every mesh, as laid out by BVH::ToGPUData(), into a 4-wide tree
+    struct WideBVH {
+        std::vector<WideNode> nodes;
+        std::vector<TriangleData> triangles; // Same indices as the scene triangles
+        std::vector<uint32_t> roots;         // One per mesh, in mesh order
+
+        static WideBVH Build(std::span<const BVH_FlattenNode> nodes,
+                             std::span<const Triangle> triangles,
+                             std::span<const Mesh> meshes);
+    };
+}
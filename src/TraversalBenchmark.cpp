@@ -0,0 +1,213 @@
+#include "TraversalBenchmark.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "Core/Log.h"
+#include "Raytracer/Raytracer.h"
+#include "Traversal/Traversal.h"
+
+namespace {
+    using namespace Traversal;
+
+    constexpr double MIN_SECONDS = 0.25; // Every measure repeats its pass until then
+    constexpr float EPSILON = 1e-4f;     // Bounce origin offset, as in main.comp
+
+    // Camera rays through pixel centers in row order, so that packets gather neighbouring pixels
+    std::vector<Ray> PrimaryRays(const CameraData& camera, const uint32_t width, const uint32_t height) {
+        const float focalLength = 1.0f / std::tan(camera.fovRad * 0.5f);
+        const float aspect = static_cast<float>(width) / static_cast<float>(height);
+
+        std::vector<Ray> rays;
+        rays.reserve(static_cast<size_t>(width) * height);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const float sx = ((static_cast<float>(x) + 0.5f) / static_cast<float>(width) * 2.0f - 1.0f) * aspect;
+                const float sy = (static_cast<float>(y) + 0.5f) / static_cast<float>(height) * 2.0f - 1.0f;
+                rays.push_back({
+                    camera.cameraPosition,
+                    glm::normalize(sx * camera.cameraRight + sy * camera.cameraUp + focalLength * camera.cameraForward),
+                });
+            }
+        }
+        return rays;
+    }
+
+    // Diffuse bounces off the primary hits, missed rays leave the camera in a random direction
+    std::vector<Ray> BounceRays(const WideBVH& bvh, const std::vector<Ray>& primary, const std::vector<Hit>& hits) {
+        std::mt19937 generator(42);
+        std::normal_distribution<float> gauss;
+
+        std::vector<Ray> rays;
+        rays.reserve(primary.size());
+        for (size_t i = 0; i < primary.size(); ++i) {
+            glm::vec3 dir = glm::normalize(glm::vec3(gauss(generator), gauss(generator), gauss(generator)));
+            if (!hits[i].DidHit()) {
+                rays.push_back({primary[i].ori, dir});
+                continue;
+            }
+
+            const float* n = bvh.triangles[hits[i].triangle].normal;
+            const glm::vec3 normal = glm::normalize(glm::vec3(n[0], n[1], n[2]));
+            if (glm::dot(dir, normal) < 0.0f) dir = -dir;
+            rays.push_back({primary[i].ori + primary[i].dir * hits[i].dst + normal * EPSILON, dir});
+        }
+        return rays;
+    }
+
+    // Distances rather than triangle indices: kernels visiting leaves in another order may report another
+    // triangle at the same distance, on a shared edge. The tolerance absorbs compilers contracting to FMA.
+    bool SameHit(const Hit& a, const Hit& b) {
+        if (a.DidHit() != b.DidHit()) return false;
+        return !a.DidHit() || std::abs(a.dst - b.dst) <= 1e-4f * std::max(1.0f, b.dst);
+    }
+
+    struct Measure {
+        double raysPerSecond = 0.0;
+        size_t mismatches = 0; // Hits differing from the scalar kernel
+    };
+
+    Measure Time(const Engine& engine,
+                 const std::vector<Ray>& rays,
+                 const std::vector<Hit>& reference,
+                 const bool packets) {
+        std::vector<Hit> hits(rays.size());
+        uint64_t traced = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        do {
+            std::ranges::fill(hits, Hit{});
+            if (packets) {
+                engine.Intersect(rays, hits);
+            } else {
+                for (size_t i = 0; i < rays.size(); ++i) engine.Intersect(rays[i], hits[i]);
+            }
+            traced += rays.size();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (seconds < MIN_SECONDS);
+
+        Measure measure{.raysPerSecond = static_cast<double>(traced) / seconds};
+        for (size_t i = 0; i < hits.size(); ++i) {
+            if (!SameHit(hits[i], reference[i])) ++measure.mismatches;
+        }
+        return measure;
+    }
+
+    // Any-hit queries over the flattened tree, without a bound: a ray is occluded exactly when it has a closest hit
+    Measure TimeOcclusion(const Scene& scene, const std::vector<Ray>& rays, const std::vector<Hit>& reference) {
+        std::vector<bool> occluded(rays.size());
+        uint64_t traced = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        do {
+            for (size_t i = 0; i < rays.size(); ++i) {
+                occluded[i] = Occluded(scene.GetBVHNodes(), scene.GetTriangles(), scene.GetMeshes(), rays[i], FLT_MAX);
+            }
+            traced += rays.size();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (seconds < MIN_SECONDS);
+
+        Measure measure{.raysPerSecond = static_cast<double>(traced) / seconds};
+        for (size_t i = 0; i < rays.size(); ++i) {
+            if (occluded[i] != reference[i].DidHit()) ++measure.mismatches;
+        }
+        return measure;
+    }
+
+    // Frames the mesh bounds from the front
+    Camera FrameMeshes(const Scene& scene) {
+        glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+        for (const Triangle& t : scene.GetTriangles()) {
+            min = glm::min(min, glm::min(t.a, glm::min(t.b, t.c)));
+            max = glm::max(max, glm::max(t.a, glm::max(t.b, t.c)));
+        }
+
+        const glm::vec3 center = (min + max) * 0.5f;
+        const float radius = glm::length(max - min) * 0.5f;
+        return Camera(center + glm::vec3(0.0f, 0.0f, radius * 1.5f), {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, 60.0f);
+    }
+}
+
+TraversalBenchmark::TraversalBenchmark(const CommandLine::Options& options) : options(options) {}
+
+int TraversalBenchmark::Run() const {
+    LOGI("Traversal benchmark: {}x{} rays per pass, best ISA {}",
+         options.width, options.height, ToString(DetectIsa()));
+
+    if (!options.scene.empty()) {
+        Raytracer raytracer(options.width, options.height);
+        if (!raytracer.LoadFromFile(options.scene)) return EXIT_FAILURE;
+        RunScene(options.scene.filename().string(), raytracer.GetScene(), raytracer.GetCamera());
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<std::filesystem::path> meshes;
+    for (const auto& entry : std::filesystem::directory_iterator(ASSETS_PATH)) {
+        if (entry.path().extension() == ".obj") meshes.push_back(entry.path().filename());
+    }
+    std::ranges::sort(meshes);
+
+    constexpr Material material = {
+        .color = {0.8f, 0.8f, 0.8f},
+        .smoothness = 0.0f,
+        .emissionColor = {0.0f, 0.0f, 0.0f},
+        .emissionStrength = 0.0f,
+    };
+
+    for (const auto& mesh : meshes) {
+        Scene scene;
+        if (!scene.AddMesh(mesh, material)) return EXIT_FAILURE;
+        RunScene(mesh.string(), scene, FrameMeshes(scene));
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void TraversalBenchmark::RunScene(const std::string& name, const Scene& scene, const Camera& camera) const {
+    const auto& nodes = scene.GetBVHNodes();
+    const auto& triangles = scene.GetTriangles();
+    const auto& meshes = scene.GetMeshes();
+
+    // Scalar hits are the reference of the other kernels, and the origin of the bounce rays
+    const Engine reference(nodes, triangles, meshes, Isa::Scalar);
+
+    const std::vector<Ray> primary = PrimaryRays(camera.GetData(), options.width, options.height);
+    std::vector<Hit> primaryHits(primary.size());
+    reference.Intersect(primary, primaryHits);
+
+    const std::vector<Ray> bounce = BounceRays(reference.GetBVH(), primary, primaryHits);
+    std::vector<Hit> bounceHits(bounce.size());
+    reference.Intersect(bounce, bounceHits);
+
+    const auto hitCount = std::ranges::count_if(primaryHits, [](const Hit& hit) { return hit.DidHit(); });
+    LOGI("{}: {} triangles, {} wide nodes, {:.1f}% primary hits",
+         name, triangles.size(), reference.GetBVH().nodes.size(), 100.0 * hitCount / primary.size());
+
+    for (const Isa isa : {Isa::Scalar, Isa::SSE41, Isa::AVX2}) {
+        if (!IsSupported(isa)) {
+            LOGI("  {:<7} not supported", ToString(isa));
+            continue;
+        }
+
+        const Engine engine(nodes, triangles, meshes, isa);
+        const Measure primarySingle = Time(engine, primary, primaryHits, false);
+        const Measure primaryPacket = Time(engine, primary, primaryHits, true);
+        const Measure bounceSingle = Time(engine, bounce, bounceHits, false);
+        const Measure bouncePacket = Time(engine, bounce, bounceHits, true);
+
+        LOGI("  {:<7} primary {:8.2f} Mrays/s single, {:8.2f} packet x{} | bounce {:8.2f} single, {:8.2f} packet "
+             "| {} mismatches",
+             ToString(isa), primarySingle.raysPerSecond * 1e-6, primaryPacket.raysPerSecond * 1e-6,
+             engine.GetPacketWidth(), bounceSingle.raysPerSecond * 1e-6, bouncePacket.raysPerSecond * 1e-6,
+             primarySingle.mismatches + primaryPacket.mismatches + bounceSingle.mismatches + bouncePacket.mismatches);
+    }
+
+    const Measure occlusion = TimeOcclusion(scene, bounce, bounceHits);
+    LOGI("  {:<7} bounce {:8.2f} Mrays/s any-hit, flattened BVH | {} mismatches",
+         "Occluded", occlusion.raysPerSecond * 1e-6, occlusion.mismatches);
+}
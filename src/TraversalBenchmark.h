@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Core/CommandLine.h"
+#include "Raytracer/Camera.h"
+#include "Raytracer/Scene.h"
+
+// Compares the CPU traversal kernels of every ISA level the CPU supports, single-threaded, on coherent
+// primary rays and on incoherent bounce rays. Runs on the given scene, or on each bundled mesh otherwise.
+class TraversalBenchmark {
+public:
+    explicit TraversalBenchmark(const CommandLine::Options& options);
+    ~TraversalBenchmark() = default;
+
+    // Returns the process exit code
+    int Run() const;
+
+private:
+    void RunScene(const std::string& name, const Scene& scene, const Camera& camera) const;
+
+private:
+    CommandLine::Options options;
+};
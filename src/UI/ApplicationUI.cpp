@@ -1,16 +1,87 @@
 #include "ApplicationUI.h"
 
+#include <string>
+
 #include <imgui.h>
 
 #include "Application.h"
+#include "BaseUI.h"
 #include "RaytracerUI.h"
 
+namespace {
+    void DrawGpuScopes(const GpuProfiler& profiler) {
+        if (!profiler.IsEnabled()) {
+            ImGui::TextDisabled("Timestamps not supported");
+            return;
+        }
+
+        for (const auto& scope : profiler.GetStats()) {
+            ImGui::Text("%s: %.3f ms (min %.3f, max %.3f)",
+                        scope.name.c_str(), scope.averageMs, scope.minMs, scope.maxMs);
+        }
+    }
+}
+
 void UI::DrawApplication(Application& app) {
     ImGui::Begin("[INFO]");
     ImGui::SeparatorText("[APPLICATION]");
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+    ImGui::SeparatorText("[RENDERER]");
+    const auto& frameStats = app.renderer->GetFrameStats();
+    ImGui::Text("CPU frame: %.2f ms", frameStats.cpuFrameMs);
+    ImGui::Text("Fence wait: %.2f ms", frameStats.fenceWaitMs);
+    ImGui::Text("GPU starved: %.0f%%", frameStats.gpuStarvedRatio * 100.0f);
+    ImGui::Text("Samples: %u (%u per frame)", app.renderer->GetSampleCount(), app.renderer->GetSamplesPerDispatch());
+    ImGui::Text("Accumulation: %s", app.renderer->IsIdle() ? "done, waiting for input" : "running");
+    if (app.renderer->GetRenderScale() < 1.0f) {
+        ImGui::Text("Render scale: %.0f%%", app.renderer->GetRenderScale() * 100.0f);
+    }
+    if (const TileScheduler* tiles = app.renderer->GetTileScheduler()) {
+        ImGui::Text("Tiles: %u of %u per frame", tiles->GetTilesPerFrame(), tiles->GetTileCount());
+    }
+    ImGui::Text("Vulkan objects created: %u (total %llu)",
+                frameStats.objectCreations,
+                static_cast<unsigned long long>(frameStats.totalObjectCreations));
+    ImGui::SeparatorText("[GPU]");
+    DrawGpuScopes(app.renderer->GetGpuProfiler());
+    DrawGpuScopes(app.renderer->GetUploadProfiler());
+    if (ImGui::Button("Reset##GpuProfiler")) app.renderer->ResetGpuStats();
+    ImGui::SameLine();
+    if (ImGui::Button("Save##GpuProfiler")) ImGui::OpenPopup("SaveGpuProfilePopup");
+
+    static std::string profileFilename;
+    InputFilenamePopup("SaveGpuProfilePopup",
+                       "Save",
+                       profileFilename,
+                       ".json",
+                       [&](const std::filesystem::path& filepath) {
+                           app.renderer->SaveGpuProfile(filepath);
+                       });
+
     ImGui::SeparatorText("[WINDOW]");
     ImGui::Text("Window size: (%d, %d)", app.window->GetWidth(), app.window->GetHeight());
+    ImGui::SeparatorText("[CAMERA PATH]");
+    if (ImGui::Button(app.recordingPath ? "Stop" : "Record")) {
+        // Recording starts from the current pose
+        if (!app.recordingPath) app.recordedPath.AddKeyframe(app.raytracer->GetCamera());
+        app.recordingPath = !app.recordingPath;
+        app.timeSinceKeyframe = 0.0f;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear##CameraPath")) app.recordedPath.Clear();
+    ImGui::SameLine();
+    if (ImGui::Button("Save##CameraPath")) ImGui::OpenPopup("SaveCameraPathPopup");
+    ImGui::Text("Keyframes: %zu", app.recordedPath.Size());
+
+    static std::string filename;
+    InputFilenamePopup("SaveCameraPathPopup",
+                       "Save",
+                       filename,
+                       ".json",
+                       [&](const std::filesystem::path& filepath) {
+                           app.recordedPath.SaveToFile(filepath);
+                       });
+
     ImGui::SeparatorText("[RAYTRACER]");
     DrawRaytracer(*app.raytracer);
     ImGui::End();
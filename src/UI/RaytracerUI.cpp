@@ -7,6 +7,7 @@
 #include "BaseUI.h"
 #include "CameraUI.h"
 #include "SceneUI.h"
+#include "SettingsUI.h"
 
 void UI::DrawRaytracer(Raytracer& raytracer) {
     if (ImGui::Button("Load")) ImGui::OpenPopup("LoadPopup");
@@ -32,6 +33,10 @@ void UI::DrawRaytracer(Raytracer& raytracer) {
                        });
 
 
+    if (DrawSettings(raytracer.GetSettings())) {
+        raytracer.SetDirty(DirtyFlags::Settings);
+    }
+
     if (DrawCamera(raytracer.GetCamera())) {
         raytracer.SetDirty(DirtyFlags::Camera);
     }
@@ -0,0 +1,110 @@
+#include "SettingsUI.h"
+
+#include <imgui.h>
+
+bool UI::DrawSettings(RenderSettings& settings) {
+    bool changed = false;
+
+    if (ImGui::TreeNode("Render")) {
+        ImGui::Indent();
+
+        ImGui::SeparatorText("Integrator");
+        if (ImGui::BeginCombo("Kernel", ToString(settings.integrator))) {
+            for (const Integrator integrator : INTEGRATORS) {
+                if (ImGui::Selectable(ToString(integrator), integrator == settings.integrator)) {
+                    settings.integrator = integrator;
+                    changed = true;
+                }
+            }
+            ImGui::EndCombo();
+        }
+
+        if (settings.integrator == Integrator::Wavefront) {
+            changed |= ImGui::Checkbox("Sort rays", &settings.sortRays);
+        }
+
+        // Tiles split the megakernel dispatch over frames to keep the UI responsive
+        if (settings.integrator == Integrator::Megakernel) {
+            changed |= ImGui::SliderFloat("Tile budget (ms)", &settings.tileBudgetMs, 0.0f, 100.0f,
+                                          settings.tileBudgetMs > 0.0f ? "%.1f" : "Off");
+            if (settings.tileBudgetMs > 0.0f && ImGui::BeginCombo("Tile order", ToString(settings.tileOrder))) {
+                for (const TileOrder order : TILE_ORDERS) {
+                    if (ImGui::Selectable(ToString(order), order == settings.tileOrder)) {
+                        settings.tileOrder = order;
+                        changed = true;
+                    }
+                }
+                ImGui::EndCombo();
+            }
+        }
+
+        int maxBounces = static_cast<int>(settings.maxBounces);
+        if (ImGui::SliderInt("Max bounces", &maxBounces, 1, MAX_BOUNCES)) {
+            settings.maxBounces = static_cast<uint32_t>(maxBounces);
+            changed = true;
+        }
+
+        changed |= ImGui::Checkbox("Russian roulette", &settings.russianRoulette);
+        if (settings.russianRoulette) {
+            int minDepth = static_cast<int>(settings.rouletteMinDepth);
+            if (ImGui::SliderInt("Min depth", &minDepth, 1, MAX_BOUNCES)) {
+                settings.rouletteMinDepth = static_cast<uint32_t>(minDepth);
+                changed = true;
+            }
+        }
+
+        changed |= ImGui::Checkbox("Light sampling", &settings.lightSampling);
+
+        ImGui::SeparatorText("Sampling");
+        if (ImGui::BeginCombo("Sequence", ToString(settings.sampleSequence))) {
+            for (const SampleSequence sequence : SAMPLE_SEQUENCES) {
+                if (ImGui::Selectable(ToString(sequence), sequence == settings.sampleSequence)) {
+                    settings.sampleSequence = sequence;
+                    changed = true;
+                }
+            }
+            ImGui::EndCombo();
+        }
+
+        int samples = static_cast<int>(settings.samplesPerDispatch);
+        if (ImGui::SliderInt("Samples per frame", &samples, 1, MAX_SAMPLES_PER_DISPATCH)) {
+            settings.samplesPerDispatch = static_cast<uint32_t>(samples);
+            changed = true;
+        }
+
+        // The budget takes over the samples per frame, starting from the value above
+        changed |= ImGui::SliderFloat("Frame budget (ms)", &settings.frameBudgetMs, 0.0f, 100.0f,
+                                      settings.frameBudgetMs > 0.0f ? "%.1f" : "Off");
+
+        int maxSamples = static_cast<int>(settings.maxSamples);
+        if (ImGui::SliderInt("Max samples", &maxSamples, 0, 65536, maxSamples > 0 ? "%d" : "Off",
+                             ImGuiSliderFlags_Logarithmic)) {
+            settings.maxSamples = static_cast<uint32_t>(maxSamples);
+            changed = true;
+        }
+
+        changed |= ImGui::Checkbox("Adaptive sampling", &settings.adaptiveSampling);
+        if (settings.adaptiveSampling) {
+            changed |= ImGui::SliderFloat("Error threshold", &settings.adaptiveThreshold, 1e-3f, 0.2f, "%.3f",
+                                          ImGuiSliderFlags_Logarithmic);
+
+            int minSamples = static_cast<int>(settings.adaptiveMinSamples);
+            if (ImGui::SliderInt("Min samples", &minSamples, 2, 256)) {
+                settings.adaptiveMinSamples = static_cast<uint32_t>(minSamples);
+                changed = true;
+            }
+        }
+
+        ImGui::SeparatorText("Display");
+        changed |= ImGui::Checkbox("Tone mapping", &settings.toneMapping);
+
+        // Lower resolution while the camera moves, full resolution again once it stops
+        changed |= ImGui::SliderFloat("Motion budget (ms)", &settings.motionFrameMs, 0.0f, 100.0f,
+                                      settings.motionFrameMs > 0.0f ? "%.1f" : "Off");
+
+        ImGui::Unindent();
+        ImGui::TreePop();
+    }
+
+    return changed;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "Raytracer/RenderSettings.h"
+
+namespace UI {
+    bool DrawSettings(RenderSettings& settings);
+};
@@ -24,6 +24,7 @@ Buffer::Buffer(const std::shared_ptr<VulkanContext>& context,
 
     memory = context->device.allocateMemory(allocInfo);
     context->device.bindBufferMemory(buffer, memory, 0);
+    context->TrackCreation(2);
 }
 
 Buffer::~Buffer() {
@@ -76,30 +77,33 @@ void Buffer::Update(const void* data, const vk::DeviceSize size) const {
     }
 }
 
+void Buffer::Read(void* data, const vk::DeviceSize size) const {
+    if (size > bufferSize) {
+        LOGE("Trying to read {} bytes from buffer of size {}", size, bufferSize);
+        return;
+    }
+
+    void* mapped = nullptr;
+    const vk::Result result = vulkanContext->device.mapMemory(memory, 0, size, {}, &mapped);
+
+    if (result == vk::Result::eSuccess) {
+        memcpy(data, mapped, size);
+        vulkanContext->device.unmapMemory(memory);
+    } else {
+        LOGE("Failed to map memory! Error: {}", vk::to_string(result));
+    }
+}
+
 StorageBuffer::StorageBuffer(const std::shared_ptr<VulkanContext>& context, const vk::DeviceSize initialSize) :
     context(context) {
-    // Buffer device-local (GPU)
-    buffer = std::make_unique<Buffer>(
-        context,
-        initialSize,
-        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
-        vk::MemoryPropertyFlagBits::eDeviceLocal
-    );
-
-    // Buffer staging (CPU visible)
-    stagingBuffer = std::make_unique<Buffer>(
-        context,
-        initialSize,
-        vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-    );
+    buffer = CreateDeviceBuffer(initialSize);
+    backBuffer = CreateDeviceBuffer(initialSize);
+    stagingBuffer = CreateStagingBuffer(initialSize);
 
     needsUpload = false;
 }
 
-void StorageBuffer::Upload(const vk::CommandBuffer commandBuffer,
-                           const vk::PipelineStageFlags2 dstStageMask,
-                           const vk::AccessFlags2 dstAccessMask) const {
+void StorageBuffer::Upload(const vk::CommandBuffer transferCommandBuffer) const {
     if (!needsUpload || stagedSize == 0) {
         return;
     }
@@ -108,54 +112,93 @@ void StorageBuffer::Upload(const vk::CommandBuffer commandBuffer,
         .size = stagedSize,
     };
 
-    commandBuffer.copyBuffer(stagingBuffer->GetHandle(), buffer->GetHandle(), copyRegion);
+    transferCommandBuffer.copyBuffer(stagingBuffer->GetHandle(), backBuffer->GetHandle(), copyRegion);
 
-    const vk::BufferMemoryBarrier2 barrier{
-        .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
-        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
-        .dstStageMask = dstStageMask,
-        .dstAccessMask = dstAccessMask,
-        .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
-        .buffer = buffer->GetHandle(),
-        .offset = 0,
-        .size = stagedSize,
-    };
+    // Without a dedicated queue the timeline wait between both submissions is enough
+    if (context->HasDedicatedTransferQueue()) {
+        vk::BufferMemoryBarrier2 release = OwnershipBarrier(backBuffer->GetHandle());
+        release.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+        release.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+
+        const vk::DependencyInfo depInfo{
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers = &release
+        };
+        transferCommandBuffer.pipelineBarrier2(depInfo);
+    }
+
+    needsUpload = false;
+    needsCommit = true;
+}
+
+void StorageBuffer::Commit() {
+    if (!needsCommit) return;
+
+    std::swap(buffer, backBuffer);
+
+    needsCommit = false;
+    needsAcquire = context->HasDedicatedTransferQueue();
+}
+
+void StorageBuffer::Acquire(const vk::CommandBuffer commandBuffer,
+                            const vk::PipelineStageFlags2 dstStageMask,
+                            const vk::AccessFlags2 dstAccessMask) const {
+    if (!needsAcquire) return;
+
+    vk::BufferMemoryBarrier2 acquire = OwnershipBarrier(buffer->GetHandle());
+    acquire.dstStageMask = dstStageMask;
+    acquire.dstAccessMask = dstAccessMask;
 
     const vk::DependencyInfo depInfo{
         .bufferMemoryBarrierCount = 1,
-        .pBufferMemoryBarriers = &barrier
+        .pBufferMemoryBarriers = &acquire
     };
     commandBuffer.pipelineBarrier2(depInfo);
 
-    needsUpload = false;
+    needsAcquire = false;
 }
 
 void StorageBuffer::EnsureCapacity(const vk::DeviceSize requiredSize) {
-    if (requiredSize <= buffer->GetSize()) return;
+    if (requiredSize <= backBuffer->GetSize()) return;
 
-    auto growingSize = buffer->GetSize();
+    auto growingSize = backBuffer->GetSize();
     while (growingSize < requiredSize) {
         growingSize *= GROW_FACTOR;
     }
 
-    context->device.waitIdle();
-    changed = true;
-    CreateBuffers(growingSize);
+    // Only the back and staging buffers are replaced, the caller guarantees
+    // that no submission still references them.
+    backBuffer = CreateDeviceBuffer(growingSize);
+    if (stagingBuffer->GetSize() < requiredSize) stagingBuffer = CreateStagingBuffer(growingSize);
 }
 
-void StorageBuffer::CreateBuffers(vk::DeviceSize size) {
-    buffer = std::make_unique<Buffer>(
+std::unique_ptr<Buffer> StorageBuffer::CreateDeviceBuffer(const vk::DeviceSize size) const {
+    // Buffer device-local (GPU)
+    return std::make_unique<Buffer>(
         context,
         size,
         vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
         vk::MemoryPropertyFlagBits::eDeviceLocal
     );
+}
 
-    stagingBuffer = std::make_unique<Buffer>(
+std::unique_ptr<Buffer> StorageBuffer::CreateStagingBuffer(const vk::DeviceSize size) const {
+    // Buffer staging (CPU visible)
+    return std::make_unique<Buffer>(
         context,
         size,
         vk::BufferUsageFlagBits::eTransferSrc,
         vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
     );
 }
+
+vk::BufferMemoryBarrier2 StorageBuffer::OwnershipBarrier(const vk::Buffer target) const {
+    // Release and acquire must describe the same range and queue families
+    return vk::BufferMemoryBarrier2{
+        .srcQueueFamilyIndex = context->transferQueueIndex,
+        .dstQueueFamilyIndex = context->graphicsQueueIndex,
+        .buffer = target,
+        .offset = 0,
+        .size = vk::WholeSize,
+    };
+}
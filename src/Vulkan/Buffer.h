@@ -44,6 +44,18 @@ public:
         Update(&data, sizeof(T));
     }
 
+    // Host-visible buffers only, the caller waits for the GPU writes first
+    template <typename T>
+    void Read(std::vector<T>& data) const {
+        data.resize(bufferSize / sizeof(T));
+        Read(data.data(), sizeof(T) * data.size());
+    }
+
+    template <typename T>
+    void Read(T& data) const {
+        Read(&data, sizeof(T));
+    }
+
     vk::Buffer GetHandle() const { return buffer; }
     vk::DeviceMemory GetMemory() const { return memory; }
     vk::DeviceSize GetSize() const { return bufferSize; }
@@ -56,6 +68,7 @@ public:
 
 private:
     void Update(const void* data, vk::DeviceSize size) const;
+    void Read(void* data, vk::DeviceSize size) const;
 
 private:
     std::shared_ptr<VulkanContext> vulkanContext;
@@ -65,13 +78,22 @@ private:
     vk::DeviceMemory memory;
 };
 
+// Device-local buffer updated through a staging copy.
+// Uploads land in a back buffer so frames keep reading the front one until Commit().
 class StorageBuffer {
 public:
     StorageBuffer(const std::shared_ptr<VulkanContext>& context, vk::DeviceSize initialSize);
 
-    void Upload(vk::CommandBuffer commandBuffer,
-                vk::PipelineStageFlags2 dstStageMask = vk::PipelineStageFlagBits2::eAllCommands,
-                vk::AccessFlags2 dstAccessMask = vk::AccessFlagBits2::eShaderRead) const;
+    // Records the staging copy and, with a dedicated transfer queue, the ownership release
+    void Upload(vk::CommandBuffer transferCommandBuffer) const;
+
+    // Makes the last uploaded data the front buffer once its upload has completed
+    void Commit();
+
+    // Records the ownership acquire matching Upload() on the graphics queue
+    void Acquire(vk::CommandBuffer commandBuffer,
+                 vk::PipelineStageFlags2 dstStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+                 vk::AccessFlags2 dstAccessMask = vk::AccessFlagBits2::eShaderRead) const;
 
     template <typename T>
     void Update(const std::vector<T>& data) {
@@ -95,24 +117,27 @@ public:
     }
 
     bool ShouldUpload() const { return needsUpload; }
-    bool Changed() const { return changed; }
-    void ResetChanged() const { changed = false; }
     vk::Buffer GetHandle() const { return buffer->GetHandle(); }
     vk::DeviceSize GetSize() const { return buffer->GetSize(); }
 
 private:
     void EnsureCapacity(vk::DeviceSize requiredSize);
-    void CreateBuffers(vk::DeviceSize size);
+    std::unique_ptr<Buffer> CreateDeviceBuffer(vk::DeviceSize size) const;
+    std::unique_ptr<Buffer> CreateStagingBuffer(vk::DeviceSize size) const;
+
+    vk::BufferMemoryBarrier2 OwnershipBarrier(vk::Buffer target) const;
 
 private:
     static constexpr float GROW_FACTOR = 2.0f;
 
     std::shared_ptr<VulkanContext> context;
 
-    std::unique_ptr<Buffer> buffer;
+    std::unique_ptr<Buffer> buffer;     // Front: bound to descriptor sets
+    std::unique_ptr<Buffer> backBuffer; // Back: destination of the pending upload
     std::unique_ptr<Buffer> stagingBuffer;
 
     mutable vk::DeviceSize stagedSize = 0;
     mutable bool needsUpload = false;
-    mutable bool changed = false;
+    mutable bool needsCommit = false;
+    mutable bool needsAcquire = false;
 };
@@ -0,0 +1,146 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+
+#include "Core/Log.h"
+
+namespace {
+    constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+}
+
+GpuProfiler::GpuProfiler(const std::shared_ptr<VulkanContext>& context,
+                         const uint32_t queueFamilyIndex,
+                         const uint32_t slotCount,
+                         const uint32_t maxScopes) :
+    vulkanContext(context),
+    maxScopes(maxScopes),
+    slots(slotCount) {
+    const auto families = context->physicalDevice.getQueueFamilyProperties();
+    const uint32_t validBits = families[queueFamilyIndex].timestampValidBits;
+    if (validBits == 0) {
+        LOGW("Queue family {} does not support timestamps, GPU profiling disabled", queueFamilyIndex);
+        return;
+    }
+
+    timestampMask = validBits >= 64 ? ~uint64_t{0} : (uint64_t{1} << validBits) - 1;
+    timestampPeriod = context->physicalDevice.getProperties().limits.timestampPeriod;
+
+    const vk::QueryPoolCreateInfo queryPoolInfo{
+        .queryType = vk::QueryType::eTimestamp,
+        .queryCount = slotCount * maxScopes * 2,
+    };
+    queryPool = context->device.createQueryPool(queryPoolInfo);
+    context->TrackCreation();
+
+    // Queries must be reset before their first use
+    context->device.resetQueryPool(queryPool, 0, queryPoolInfo.queryCount);
+}
+
+GpuProfiler::~GpuProfiler() {
+    if (queryPool) vulkanContext->device.destroyQueryPool(queryPool);
+}
+
+void GpuProfiler::BeginFrame(const uint32_t slot) {
+    currentSlot = slot;
+    if (!queryPool) return;
+
+    ReadSlot(slot);
+    slots[slot].scopes.clear();
+
+    // Reset from the host: transfer queues cannot record vkCmdResetQueryPool
+    vulkanContext->device.resetQueryPool(queryPool, FirstQuery(slot), maxScopes * 2);
+    slots[slot].recording = true;
+}
+
+uint32_t GpuProfiler::BeginScope(const vk::CommandBuffer cmd, const std::string_view name) {
+    if (!queryPool) return INVALID_SCOPE;
+
+    auto& slot = slots[currentSlot];
+    if (!slot.recording || slot.scopes.size() >= maxScopes) return INVALID_SCOPE;
+
+    const auto scope = static_cast<uint32_t>(slot.scopes.size());
+    slot.scopes.emplace_back(name);
+
+    // All-commands timestamps bracket the work recorded in between, scopes in sequence add up to the frame
+    cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, queryPool, FirstQuery(currentSlot) + scope * 2);
+    return scope;
+}
+
+void GpuProfiler::EndScope(const vk::CommandBuffer cmd, const uint32_t scope) {
+    if (scope == INVALID_SCOPE) return;
+
+    cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, queryPool, FirstQuery(currentSlot) + scope * 2 + 1);
+}
+
+void GpuProfiler::Collect() {
+    if (!queryPool) return;
+
+    for (uint32_t slot = 0; slot < slots.size(); ++slot) {
+        // Read slots are left empty, BeginFrame() then has nothing to read twice
+        if (ReadSlot(slot)) slots[slot].scopes.clear();
+    }
+}
+
+bool GpuProfiler::ReadSlot(const uint32_t slot) {
+    auto& [scopes, recording] = slots[slot];
+    if (!recording || scopes.empty()) return false;
+
+    // Timestamp and availability pairs, NotReady is returned instead of blocking
+    const auto queryCount = static_cast<uint32_t>(scopes.size() * 2);
+    std::vector<uint64_t> results(queryCount * 2);
+    const vk::Result result = vulkanContext->device.getQueryPoolResults(
+        queryPool,
+        FirstQuery(slot),
+        queryCount,
+        results.size() * sizeof(uint64_t),
+        results.data(),
+        2 * sizeof(uint64_t),
+        vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+    if (result != vk::Result::eSuccess && result != vk::Result::eNotReady) return false;
+
+    // A slot is only accumulated once all its scopes are available, so it is never counted twice
+    for (size_t query = 0; query < queryCount; ++query) {
+        if (!results[query * 2 + 1]) return false;
+    }
+
+    for (size_t scope = 0; scope < scopes.size(); ++scope) {
+        const uint64_t ticks = (results[scope * 4 + 2] - results[scope * 4]) & timestampMask;
+        Accumulate(scopes[scope], static_cast<float>(static_cast<double>(ticks) * timestampPeriod * 1e-6));
+    }
+
+    recording = false;
+    return true;
+}
+
+void GpuProfiler::Accumulate(const std::string& name, const float ms) {
+    auto it = std::ranges::find(stats, name, &ScopeStats::name);
+    if (it == stats.end()) {
+        stats.push_back({.name = name, .averageMs = ms, .minMs = ms, .maxMs = ms});
+        it = std::prev(stats.end());
+    }
+
+    // Same smoothing as the CPU frame statistics
+    constexpr float smoothing = 0.05f;
+    it->lastMs = ms;
+    it->averageMs += smoothing * (ms - it->averageMs);
+    it->minMs = std::min(it->minMs, ms);
+    it->maxMs = std::max(it->maxMs, ms);
+    it->totalMs += ms;
+    it->count++;
+}
+
+Json GpuProfiler::ToJson() const {
+    Json scopes = Json::array();
+    for (const auto& s : stats) {
+        scopes.push_back({
+            {"name", s.name},
+            {"count", s.count},
+            {"meanMs", s.count ? s.totalMs / static_cast<double>(s.count) : 0.0},
+            {"minMs", s.minMs},
+            {"maxMs", s.maxMs},
+            {"totalMs", s.totalMs},
+        });
+    }
+    return scopes;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Serialize/Base.h"
+#include "Vulkan/Base.h"
+#include "VulkanContext.h"
+
+// Timestamp queries around named scopes, with one ring slot per frame in flight.
+// A slot's results are read back without waiting, when the slot comes around again.
+class GpuProfiler {
+public:
+    struct ScopeStats {
+        std::string name;
+        float lastMs = 0.0f;
+        float averageMs = 0.0f; // Smoothed for display
+        float minMs = 0.0f;
+        float maxMs = 0.0f;
+        double totalMs = 0.0;
+        uint64_t count = 0;
+    };
+
+    // Disabled, every call being a no-op, when the queue family has no timestamp support
+    GpuProfiler(const std::shared_ptr<VulkanContext>& context,
+                uint32_t queueFamilyIndex,
+                uint32_t slotCount,
+                uint32_t maxScopes = 16);
+    ~GpuProfiler();
+
+    // The slot's previous submission must have completed: its results are read, then its queries reset
+    void BeginFrame(uint32_t slot);
+
+    uint32_t BeginScope(vk::CommandBuffer cmd, std::string_view name);
+    void EndScope(vk::CommandBuffer cmd, uint32_t scope);
+
+    // Reads every slot whose results are available, without waiting
+    void Collect();
+
+    bool IsEnabled() const { return static_cast<bool>(queryPool); }
+    const std::vector<ScopeStats>& GetStats() const { return stats; }
+    void ResetStats() { stats.clear(); }
+
+    // Per-scope statistics accumulated since the last reset
+    Json ToJson() const;
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+private:
+    struct Slot {
+        std::vector<std::string> scopes; // Recorded since the last reset, in query order
+        bool recording = false;
+    };
+
+    bool ReadSlot(uint32_t slot);
+    void Accumulate(const std::string& name, float ms);
+    uint32_t FirstQuery(const uint32_t slot) const { return slot * maxScopes * 2; }
+
+private:
+    std::shared_ptr<VulkanContext> vulkanContext;
+
+    vk::QueryPool queryPool = nullptr;
+    uint32_t maxScopes;
+    uint64_t timestampMask = 0;
+    float timestampPeriod = 1.0f; // Nanoseconds per tick
+
+    std::vector<Slot> slots;
+    uint32_t currentSlot = 0;
+
+    std::vector<ScopeStats> stats; // In order of first appearance
+};
+
+// Times the commands recorded during its lifetime
+class GpuScope {
+public:
+    GpuScope(GpuProfiler& profiler, const vk::CommandBuffer cmd, const std::string_view name) :
+        profiler(profiler), cmd(cmd), scope(profiler.BeginScope(cmd, name)) {}
+
+    ~GpuScope() { profiler.EndScope(cmd, scope); }
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+    GpuProfiler& profiler;
+    vk::CommandBuffer cmd;
+    uint32_t scope;
+};
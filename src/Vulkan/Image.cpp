@@ -39,6 +39,7 @@ Image::Image(const std::shared_ptr<VulkanContext>& context,
 
     memory = context->device.allocateMemory(allocInfo);
     context->device.bindImageMemory(image, memory, 0);
+    context->TrackCreation(2);
 }
 
 Image::~Image() {
@@ -62,6 +63,7 @@ vk::UniqueImageView Image::CreateView(const vk::ImageAspectFlags aspectFlags,
         }
     };
 
+    vulkanContext->TrackCreation();
     return vulkanContext->device.createImageViewUnique(viewInfo);
 }
 
@@ -74,10 +76,19 @@ void Image::TransitionLayout(const vk::CommandBuffer cmd,
 
     if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eGeneral) {
         srcAccess = {};
-        dstAccess = vk::AccessFlagBits2::eShaderWrite;
+        dstAccess = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite;
+    } else if (oldLayout == vk::ImageLayout::eShaderReadOnlyOptimal && newLayout == vk::ImageLayout::eGeneral) {
+        srcAccess = vk::AccessFlagBits2::eShaderRead;
+        dstAccess = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite;
     } else if (oldLayout == vk::ImageLayout::eGeneral && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
         srcAccess = vk::AccessFlagBits2::eShaderWrite;
         dstAccess = vk::AccessFlagBits2::eShaderRead;
+    } else if (oldLayout == vk::ImageLayout::eShaderReadOnlyOptimal && newLayout == vk::ImageLayout::eTransferSrcOptimal) {
+        srcAccess = vk::AccessFlagBits2::eShaderRead;
+        dstAccess = vk::AccessFlagBits2::eTransferRead;
+    } else if (oldLayout == vk::ImageLayout::eTransferSrcOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal) {
+        srcAccess = vk::AccessFlagBits2::eTransferRead;
+        dstAccess = vk::AccessFlagBits2::eShaderRead;
     }
 
     const vk::ImageMemoryBarrier2 barrier{
@@ -33,5 +33,6 @@ std::vector<vk::UniqueDescriptorSet> Pipeline::AllocateDescriptorSets() {
         .pSetLayouts = descriptorSetLayouts.data(),
     };
 
+    vulkanContext->TrackCreation(allocInfo.descriptorSetCount);
     return vulkanContext->device.allocateDescriptorSetsUnique(allocInfo);
 }
@@ -0,0 +1,24 @@
+#include "SemaphorePool.h"
+
+SemaphorePool::SemaphorePool(const std::shared_ptr<VulkanContext>& context) : vulkanContext(context) {}
+
+SemaphorePool::~SemaphorePool() {
+    for (const auto semaphore : semaphores) vulkanContext->device.destroySemaphore(semaphore);
+}
+
+vk::Semaphore SemaphorePool::Acquire() {
+    if (!available.empty()) {
+        const vk::Semaphore semaphore = available.back();
+        available.pop_back();
+        return semaphore;
+    }
+
+    const vk::Semaphore semaphore = vulkanContext->device.createSemaphore({});
+    vulkanContext->TrackCreation();
+    semaphores.push_back(semaphore);
+    return semaphore;
+}
+
+void SemaphorePool::Recycle(const vk::Semaphore semaphore) {
+    if (semaphore) available.push_back(semaphore);
+}
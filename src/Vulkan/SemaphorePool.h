@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include "Vulkan/Base.h"
+#include "VulkanContext.h"
+
+// Binary semaphores handed back once the submission waiting on them has completed.
+// After warm-up, Acquire() never creates a new object.
+class SemaphorePool {
+public:
+    explicit SemaphorePool(const std::shared_ptr<VulkanContext>& context);
+    ~SemaphorePool();
+
+    vk::Semaphore Acquire();
+    void Recycle(vk::Semaphore semaphore);
+
+    SemaphorePool(const SemaphorePool&) = delete;
+    SemaphorePool& operator=(const SemaphorePool&) = delete;
+
+private:
+    std::shared_ptr<VulkanContext> vulkanContext;
+
+    std::vector<vk::Semaphore> semaphores;
+    std::vector<vk::Semaphore> available;
+};
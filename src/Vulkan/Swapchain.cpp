@@ -4,10 +4,12 @@ Swapchain::Swapchain(const std::shared_ptr<VulkanContext>& context, const std::s
     vulkanContext(context),
     window(window) {
     CreateSwapchain();
+    CreateFrameContexts();
 }
 
 Swapchain::~Swapchain() {
     DestroyImageViews();
+    DestroyRenderFinishedSemaphores();
     DestroyFrameContexts();
 
     vulkanContext->device.destroySwapchainKHR(swapchain);
@@ -24,16 +26,12 @@ uint32_t Swapchain::GetImageCount() const { return images.size(); }
 const std::vector<vk::ImageView>& Swapchain::GetImageViews() const { return imageViews; }
 const std::vector<vk::Image>& Swapchain::GetImages() const { return images; }
 
-FrameContext& Swapchain::GetCurrentFrameContext() {
-    if (!currentImageIndex.has_value()) {
-        throw std::runtime_error("Swapchain::GetCurrentFrameContext() : Current image index not set.");
-    }
-    frameContexts[*currentImageIndex].index = *currentImageIndex;
-    return frameContexts[*currentImageIndex];
-}
+vk::Semaphore Swapchain::GetRenderFinished(const uint32_t imageIndex) const { return renderFinished[imageIndex]; }
+
+FrameContext& Swapchain::GetCurrentFrameContext() { return frameContexts[currentFrame]; }
+const FrameContext& Swapchain::GetCurrentFrameContext() const { return frameContexts[currentFrame]; }
 
-void Swapchain::SetCurrentImageIndex(uint32_t index) { currentImageIndex = index; }
-void Swapchain::ResetCurrentImageIndex() { currentImageIndex.reset(); }
+void Swapchain::AdvanceFrame() { currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT; }
 
 void Swapchain::CreateSwapchain() {
     const vk::SurfaceCapabilitiesKHR capabilities = vulkanContext->physicalDevice.getSurfaceCapabilitiesKHR(
@@ -92,18 +90,22 @@ void Swapchain::CreateSwapchain() {
     };
 
     swapchain = vulkanContext->device.createSwapchainKHR(createInfo);
+    vulkanContext->TrackCreation();
     images = vulkanContext->device.getSwapchainImagesKHR(swapchain);
 
     if (oldSwapchain) {
-        vulkanContext->device.waitIdle();
-
-        DestroyImageViews();
-        DestroyFrameContexts();
-        vulkanContext->device.destroySwapchainKHR(oldSwapchain);
+        // Frames still in flight may render into or present from the old images
+        vulkanContext->DeferDestruction([device = vulkanContext->device, oldSwapchain,
+                                         views = std::exchange(imageViews, {}),
+                                         semaphores = std::exchange(renderFinished, {})] {
+            for (const auto& imageView : views) device.destroyImageView(imageView);
+            for (const auto& semaphore : semaphores) device.destroySemaphore(semaphore);
+            device.destroySwapchainKHR(oldSwapchain);
+        });
     }
 
     CreateImageViews();
-    CreateFrameContexts();
+    CreateRenderFinishedSemaphores();
 }
 
 void Swapchain::CreateImageViews() {
@@ -123,15 +125,28 @@ void Swapchain::CreateImageViews() {
             }
         };
         imageViews.push_back(vulkanContext->device.createImageView(viewCreateInfo));
+        vulkanContext->TrackCreation();
+    }
+}
+
+void Swapchain::CreateRenderFinishedSemaphores() {
+    assert(renderFinished.empty());
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        renderFinished.push_back(vulkanContext->device.createSemaphore({}));
+        vulkanContext->TrackCreation();
     }
 }
 
 void Swapchain::CreateFrameContexts() {
     assert(frameContexts.empty());
 
-    frameContexts.resize(images.size());
+    frameContexts.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (uint32_t i = 0; i < frameContexts.size(); ++i) {
+        auto& fc = frameContexts[i];
+        fc.frame = i;
 
-    for (auto& fc : frameContexts) {
         const vk::CommandPoolCreateInfo commandPoolCreateInfo{
             .flags = vk::CommandPoolCreateFlagBits::eTransient,
             .queueFamilyIndex = vulkanContext->graphicsQueueIndex,
@@ -145,9 +160,7 @@ void Swapchain::CreateFrameContexts() {
             .commandBufferCount = 1
         };
         fc.commandBuffer = vulkanContext->device.allocateCommandBuffers(commandBufferAllocateInfo).front();
-
-        fc.inFlight = vulkanContext->device.createFence({.flags = vk::FenceCreateFlagBits::eSignaled});
-        fc.renderFinished = vulkanContext->device.createSemaphore({});
+        vulkanContext->TrackCreation(2);
     }
 }
 
@@ -158,13 +171,18 @@ void Swapchain::DestroyImageViews() {
     }
 }
 
+void Swapchain::DestroyRenderFinishedSemaphores() {
+    if (!renderFinished.empty()) {
+        for (const auto& semaphore : renderFinished) vulkanContext->device.destroySemaphore(semaphore);
+        renderFinished.clear();
+    }
+}
+
 void Swapchain::DestroyFrameContexts() {
     if (!frameContexts.empty()) {
         for (auto& fc : frameContexts) {
-            if (fc.inFlight) vulkanContext->device.destroyFence(fc.inFlight);
             if (fc.commandBuffer) vulkanContext->device.freeCommandBuffers(fc.commandPool, fc.commandBuffer);
             if (fc.commandPool) vulkanContext->device.destroyCommandPool(fc.commandPool);
-            if (fc.renderFinished) vulkanContext->device.destroySemaphore(fc.renderFinished);
         }
         frameContexts.clear();
     }
@@ -4,17 +4,20 @@
 #include "VulkanContext.h"
 #include "Window/Window.h"
 
+// Per frame-in-flight resources, independent of the swapchain image count
 struct FrameContext {
     vk::CommandPool commandPool = nullptr;
     vk::CommandBuffer commandBuffer = nullptr;
-    vk::UniqueSemaphore imageAvailable;
-    vk::Semaphore renderFinished = nullptr;
-    vk::Fence inFlight = nullptr;
-    uint32_t index;
+    vk::Semaphore imageAvailable = nullptr; // Owned by the renderer's semaphore pool
+    uint64_t timelineValue = 0; // Graphics timeline value signaled by the slot's last submission
+    uint32_t frame;  // Frame-in-flight slot
+    uint32_t index;  // Acquired swapchain image
 };
 
 class Swapchain {
 public:
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
     Swapchain(const std::shared_ptr<VulkanContext>& context, const std::shared_ptr<Window>& window);
     ~Swapchain();
 
@@ -27,28 +30,34 @@ public:
     const std::vector<vk::ImageView>& GetImageViews() const;
     const std::vector<vk::Image>& GetImages() const;
 
+    // Signaled by the submission rendering into the image, waited on by its presentation
+    vk::Semaphore GetRenderFinished(uint32_t imageIndex) const;
+
     FrameContext& GetCurrentFrameContext();
+    const FrameContext& GetCurrentFrameContext() const;
 
-    void SetCurrentImageIndex(uint32_t index);
-    void ResetCurrentImageIndex();
+    void AdvanceFrame();
 
 private:
     void CreateSwapchain();
     void CreateImageViews();
+    void CreateRenderFinishedSemaphores();
     void CreateFrameContexts();
 
     void DestroyImageViews();
+    void DestroyRenderFinishedSemaphores();
     void DestroyFrameContexts();
 
 private:
     std::shared_ptr<VulkanContext> vulkanContext;
     std::shared_ptr<Window> window;
 
-    std::optional<uint32_t> currentImageIndex;
+    uint32_t currentFrame = 0;
 
     vk::SwapchainKHR swapchain = nullptr;
     std::vector<vk::Image> images;
     std::vector<vk::ImageView> imageViews;
+    std::vector<vk::Semaphore> renderFinished;
     std::vector<FrameContext> frameContexts;
 
     vk::Format format = vk::Format::eUndefined;
@@ -0,0 +1,45 @@
+#include "Timeline.h"
+
+Timeline::Timeline(const vk::Device device) : device(device) {
+    vk::SemaphoreTypeCreateInfo typeInfo{
+        .semaphoreType = vk::SemaphoreType::eTimeline,
+        .initialValue = 0,
+    };
+
+    semaphore = device.createSemaphore({.pNext = &typeInfo});
+}
+
+Timeline::~Timeline() {
+    if (semaphore) device.destroySemaphore(semaphore);
+}
+
+uint64_t Timeline::Completed() const {
+    if (lastCompleted < lastSubmitted) lastCompleted = device.getSemaphoreCounterValue(semaphore);
+    return lastCompleted;
+}
+
+bool Timeline::IsComplete(const uint64_t value) const {
+    return value <= lastCompleted || value <= Completed();
+}
+
+void Timeline::Wait(const uint64_t value) const {
+    if (IsComplete(value)) return;
+
+    const vk::SemaphoreWaitInfo waitInfo{
+        .semaphoreCount = 1,
+        .pSemaphores = &semaphore,
+        .pValues = &value,
+    };
+
+    const auto result = device.waitSemaphores(waitInfo, UINT64_MAX);
+    assert(result == vk::Result::eSuccess);
+    lastCompleted = std::max(lastCompleted, value);
+}
+
+vk::SemaphoreSubmitInfo Timeline::SubmitInfo(const uint64_t value, const vk::PipelineStageFlags2 stageMask) const {
+    return vk::SemaphoreSubmitInfo{
+        .semaphore = semaphore,
+        .value = value,
+        .stageMask = stageMask,
+    };
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Vulkan/Base.h"
+
+// Monotonically increasing GPU timeline backed by a timeline semaphore.
+// Each submission on the owning queue signals the value returned by Next().
+class Timeline {
+public:
+    explicit Timeline(vk::Device device);
+    ~Timeline();
+
+    uint64_t Next() { return ++lastSubmitted; }
+    uint64_t LastSubmitted() const { return lastSubmitted; }
+
+    uint64_t Completed() const;
+    bool IsComplete(uint64_t value) const;
+    void Wait(uint64_t value) const;
+
+    vk::SemaphoreSubmitInfo SubmitInfo(uint64_t value, vk::PipelineStageFlags2 stageMask) const;
+    vk::Semaphore GetHandle() const { return semaphore; }
+
+    Timeline(const Timeline&) = delete;
+    Timeline& operator=(const Timeline&) = delete;
+
+private:
+    vk::Device device;
+    vk::Semaphore semaphore;
+
+    uint64_t lastSubmitted = 0;
+    mutable uint64_t lastCompleted = 0; // Avoids querying the driver for values known to be reached
+};
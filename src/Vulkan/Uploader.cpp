@@ -0,0 +1,76 @@
+#include "Uploader.h"
+
+Uploader::Uploader(const std::shared_ptr<VulkanContext>& context) : vulkanContext(context) {
+    const vk::CommandPoolCreateInfo poolInfo{
+        .flags = vk::CommandPoolCreateFlagBits::eTransient,
+        .queueFamilyIndex = context->transferQueueIndex,
+    };
+    commandPool = context->device.createCommandPool(poolInfo);
+
+    const vk::CommandBufferAllocateInfo allocInfo{
+        .commandPool = commandPool,
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1,
+    };
+    commandBuffer = context->device.allocateCommandBuffers(allocInfo).front();
+    context->TrackCreation(2);
+}
+
+Uploader::~Uploader() {
+    vulkanContext->transferTimeline->Wait(submittedValue);
+
+    vulkanContext->device.freeCommandBuffers(commandPool, commandBuffer);
+    vulkanContext->device.destroyCommandPool(commandPool);
+}
+
+vk::CommandBuffer Uploader::Begin() {
+    assert(state == State::Idle);
+
+    vulkanContext->device.resetCommandPool(commandPool);
+    commandBuffer.begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit
+    });
+
+    state = State::Recording;
+    return commandBuffer;
+}
+
+void Uploader::Submit() {
+    assert(state == State::Recording);
+
+    commandBuffer.end();
+
+    submittedValue = vulkanContext->transferTimeline->Next();
+    const vk::CommandBufferSubmitInfo commandBufferInfo{.commandBuffer = commandBuffer};
+    const vk::SemaphoreSubmitInfo signalInfo = vulkanContext->transferTimeline->SubmitInfo(
+        submittedValue, vk::PipelineStageFlagBits2::eAllCommands);
+
+    const vk::SubmitInfo2 submitInfo{
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &commandBufferInfo,
+        .signalSemaphoreInfoCount = 1,
+        .pSignalSemaphoreInfos = &signalInfo,
+    };
+
+    vulkanContext->transferQueue.submit2(submitInfo);
+    state = State::InFlight;
+}
+
+bool Uploader::Poll() {
+    if (state != State::InFlight) return false;
+    if (!vulkanContext->transferTimeline->IsComplete(submittedValue)) return false;
+
+    state = State::Completed;
+    return true;
+}
+
+void Uploader::Wait() const {
+    if (state == State::InFlight) vulkanContext->transferTimeline->Wait(submittedValue);
+}
+
+uint64_t Uploader::ConsumeWaitValue() {
+    if (state != State::Completed) return 0;
+
+    state = State::Idle;
+    return submittedValue;
+}
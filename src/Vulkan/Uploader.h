@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Vulkan/Base.h"
+#include "VulkanContext.h"
+
+// Records buffer uploads on the transfer queue, one batch at a time.
+// A batch signals a transfer timeline value that the first graphics submission using its data must wait on.
+class Uploader {
+public:
+    explicit Uploader(const std::shared_ptr<VulkanContext>& context);
+    ~Uploader();
+
+    vk::CommandBuffer Begin();
+    void Submit();
+
+    // Returns true once, when the submitted batch has finished on the GPU
+    bool Poll();
+
+    // Blocks until the submitted batch has finished, Poll() still reports it
+    void Wait() const;
+
+    // Transfer timeline value the next graphics submission must wait on (0 if none)
+    uint64_t ConsumeWaitValue();
+
+    bool IsBusy() const { return state != State::Idle; }
+
+    Uploader(const Uploader&) = delete;
+    Uploader& operator=(const Uploader&) = delete;
+
+private:
+    enum class State {
+        Idle,
+        Recording,
+        InFlight,
+        Completed,
+    };
+
+    std::shared_ptr<VulkanContext> vulkanContext;
+
+    vk::CommandPool commandPool = nullptr;
+    vk::CommandBuffer commandBuffer = nullptr;
+    uint64_t submittedValue = 0;
+
+    State state = State::Idle;
+};
@@ -2,19 +2,35 @@
 
 #include <set>
 
+#include "Core/File.h"
 #include "Core/Log.h"
 
+static constexpr auto PIPELINE_CACHE_FILE = "pipeline_cache.bin";
+
 VulkanContext::VulkanContext(const std::shared_ptr<Window>& window) : window(window) {
     CreateInstance();
     CreateSurface();
     PickPhysicalDevice();
+    PickTransferQueueFamily();
+    QueryComputeUnits();
     CreateLogicalDevice();
     CreateDescriptorPool();
     CreateCommandPool();
+    CreateTimelines();
+    CreatePipelineCache();
 }
 
 VulkanContext::~VulkanContext() {
     if (device) {
+        FlushDeletions();
+        graphicsTimeline.reset();
+        transferTimeline.reset();
+
+        if (pipelineCache) {
+            SavePipelineCache();
+            device.destroyPipelineCache(pipelineCache);
+        }
+
         if (mainDescriptorPool) device.destroyDescriptorPool(mainDescriptorPool);
         if (commandPool) device.destroyCommandPool(commandPool);
 
@@ -39,6 +55,7 @@ vk::CommandBuffer VulkanContext::BeginSingleTimeCommands() const {
     if (device.allocateCommandBuffers(&allocInfo, &commandBuffer) != vk::Result::eSuccess) {
         throw std::runtime_error("failed to allocate command buffers!");
     }
+    TrackCreation();
 
     constexpr vk::CommandBufferBeginInfo beginInfo{
         .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
@@ -52,33 +69,70 @@ vk::CommandBuffer VulkanContext::BeginSingleTimeCommands() const {
 void VulkanContext::EndSingleTimeCommands(vk::CommandBuffer commandBuffer) const {
     commandBuffer.end();
 
-    const vk::SubmitInfo submitInfo{
-        .commandBufferCount = 1,
-        .pCommandBuffers = &commandBuffer,
+    const uint64_t value = graphicsTimeline->Next();
+    const vk::CommandBufferSubmitInfo commandBufferInfo{.commandBuffer = commandBuffer};
+    const vk::SemaphoreSubmitInfo signalInfo = graphicsTimeline->SubmitInfo(value, vk::PipelineStageFlagBits2::eAllCommands);
+
+    const vk::SubmitInfo2 submitInfo{
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &commandBufferInfo,
+        .signalSemaphoreInfoCount = 1,
+        .pSignalSemaphoreInfos = &signalInfo,
     };
 
-    const auto result = graphicsQueue.submit(1, &submitInfo, nullptr);
-    if (result != vk::Result::eSuccess) {
-        throw std::runtime_error("failed to submit command buffer !");
-    }
+    graphicsQueue.submit2(submitInfo);
 
-    graphicsQueue.waitIdle();
+    // Only this submission is waited on, frames already in flight keep running
+    graphicsTimeline->Wait(value);
 
     device.freeCommandBuffers(commandPool, 1, &commandBuffer);
 }
 
+void VulkanContext::DeferDestruction(std::move_only_function<void()> destroy) const {
+    pendingDeletions.push_back({
+        .graphicsValue = graphicsTimeline->LastSubmitted(),
+        .transferValue = transferTimeline->LastSubmitted(),
+        .destroy = std::move(destroy),
+    });
+}
+
+void VulkanContext::CollectGarbage() const {
+    // Entries are queued with non-decreasing values, so the first pending one stops the scan
+    while (!pendingDeletions.empty()) {
+        auto& deletion = pendingDeletions.front();
+        if (!graphicsTimeline->IsComplete(deletion.graphicsValue) ||
+            !transferTimeline->IsComplete(deletion.transferValue))
+            break;
+
+        deletion.destroy();
+        pendingDeletions.pop_front();
+    }
+}
+
+void VulkanContext::FlushDeletions() const {
+    while (!pendingDeletions.empty()) {
+        auto& deletion = pendingDeletions.front();
+        graphicsTimeline->Wait(deletion.graphicsValue);
+        transferTimeline->Wait(deletion.transferValue);
+
+        deletion.destroy();
+        pendingDeletions.pop_front();
+    }
+}
+
 void VulkanContext::CreateInstance() {
     static vk::detail::DynamicLoader loader;
     const auto vkGetInstanceProcAddr = loader.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr");
     VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
 
     vk::ApplicationInfo appInfo{
-        .pApplicationName = window->GetTitle(),
+        .pApplicationName = window ? window->GetTitle() : "Vulkan-RayTracer",
         .pEngineName = "",
         .apiVersion = VK_MAKE_VERSION(1, 3, 0)
     };
 
-    std::vector extensions = window->GetRequiredSurfaceExtensions();
+    std::vector<const char*> extensions;
+    if (window) extensions = window->GetRequiredSurfaceExtensions();
     std::vector<const char*> requestedInstanceLayers;
 
 #ifndef NDEBUG
@@ -124,6 +178,8 @@ void VulkanContext::CreateInstance() {
 }
 
 void VulkanContext::CreateSurface() {
+    if (IsHeadless()) return;
+
     surface = window->CreateSurface(instance);
 }
 
@@ -144,7 +200,8 @@ void VulkanContext::PickPhysicalDevice() {
             const auto& queueFamily = queueFamilies[i];
             const bool supportsGraphics = static_cast<bool>(queueFamily.queueFlags & vk::QueueFlagBits::eGraphics);
 
-            if (supportsGraphics && gpu.getSurfaceSupportKHR(i, surface)) {
+            // Headless contexts never present, software ICDs such as lavapipe qualify
+            if (supportsGraphics && (IsHeadless() || gpu.getSurfaceSupportKHR(i, surface))) {
                 graphicsQueueIndex = i;
                 physicalDevice = gpu;
                 LOGI("Selected GPU: '{}'", properties.deviceName.data());
@@ -156,10 +213,60 @@ void VulkanContext::PickPhysicalDevice() {
     throw std::runtime_error("No suitable GPU found (with Vulkan 1.3 + graphics support).");
 }
 
+void VulkanContext::PickTransferQueueFamily() {
+    transferQueueIndex = graphicsQueueIndex;
+
+    const auto queueFamilies = physicalDevice.getQueueFamilyProperties();
+    for (uint32_t i = 0; i < queueFamilies.size(); ++i) {
+        const auto flags = queueFamilies[i].queueFlags;
+        const bool transferOnly = (flags & vk::QueueFlagBits::eTransfer) &&
+            !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+
+        if (transferOnly && queueFamilies[i].queueCount > 0) {
+            transferQueueIndex = i;
+            break;
+        }
+    }
+
+    if (HasDedicatedTransferQueue()) LOGI("Using dedicated transfer queue family {}", transferQueueIndex);
+    else LOGI("No transfer-only queue family, uploads share the graphics queue");
+}
+
+void VulkanContext::QueryComputeUnits() {
+    // Core Vulkan has no such property, only vendor extensions report it
+    const auto supportedExtensions = physicalDevice.enumerateDeviceExtensionProperties();
+    const auto supports = [&](const char* name) {
+        return std::ranges::any_of(supportedExtensions, [&](const auto& e) {
+            return strcmp(e.extensionName, name) == 0;
+        });
+    };
+
+    if (supports(VK_NV_SHADER_SM_BUILTINS_EXTENSION_NAME)) {
+        computeUnitCount = physicalDevice.getProperties2<
+            vk::PhysicalDeviceProperties2,
+            vk::PhysicalDeviceShaderSMBuiltinsPropertiesNV>().get<vk::PhysicalDeviceShaderSMBuiltinsPropertiesNV>().
+            shaderSMCount;
+    } else if (supports(VK_AMD_SHADER_CORE_PROPERTIES_EXTENSION_NAME)) {
+        const auto core = physicalDevice.getProperties2<
+            vk::PhysicalDeviceProperties2,
+            vk::PhysicalDeviceShaderCorePropertiesAMD>().get<vk::PhysicalDeviceShaderCorePropertiesAMD>();
+        computeUnitCount = core.shaderEngineCount * core.shaderArraysPerEngineCount * core.computeUnitsPerShaderArray;
+    } else if (supports(VK_ARM_SHADER_CORE_PROPERTIES_EXTENSION_NAME)) {
+        computeUnitCount = physicalDevice.getProperties2<
+            vk::PhysicalDeviceProperties2,
+            vk::PhysicalDeviceShaderCorePropertiesARM>().get<vk::PhysicalDeviceShaderCorePropertiesARM>().
+            shaderCoreCount;
+    }
+
+    if (computeUnitCount != 0) LOGI("GPU reports {} compute units", computeUnitCount);
+    else LOGI("GPU does not report its compute unit count");
+}
+
 void VulkanContext::CreateLogicalDevice() {
     // Check extensions support
     auto supportedExtensions = physicalDevice.enumerateDeviceExtensionProperties();
-    std::vector<const char*> requiredExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    std::vector<const char*> requiredExtensions;
+    if (!IsHeadless()) requiredExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
     for (const char* ext : requiredExtensions) {
         bool found = std::ranges::any_of(supportedExtensions, [&](const auto& e) {
@@ -173,33 +280,55 @@ void VulkanContext::CreateLogicalDevice() {
     // Check supported features
     auto features = physicalDevice.getFeatures2<
         vk::PhysicalDeviceFeatures2,
+        vk::PhysicalDeviceVulkan12Features,
         vk::PhysicalDeviceVulkan13Features,
         vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
 
-    if (!features.get<vk::PhysicalDeviceVulkan13Features>().dynamicRendering ||
+    if (!features.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore ||
+        !features.get<vk::PhysicalDeviceVulkan12Features>().hostQueryReset ||
+        !features.get<vk::PhysicalDeviceVulkan13Features>().dynamicRendering ||
         !features.get<vk::PhysicalDeviceVulkan13Features>().synchronization2 ||
         !features.get<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>().extendedDynamicState) {
         throw std::runtime_error("Required Vulkan features not supported.");
     }
 
+    // The ray counters are reduced per subgroup before touching memory, the persistent kernel
+    // broadcasts its queue fetches
+    const auto subgroupProperties = physicalDevice.getProperties2<
+        vk::PhysicalDeviceProperties2,
+        vk::PhysicalDeviceSubgroupProperties>().get<vk::PhysicalDeviceSubgroupProperties>();
+
+    if (!(subgroupProperties.supportedStages & vk::ShaderStageFlagBits::eCompute) ||
+        !(subgroupProperties.supportedOperations & vk::SubgroupFeatureFlagBits::eArithmetic) ||
+        !(subgroupProperties.supportedOperations & vk::SubgroupFeatureFlagBits::eBallot)) {
+        throw std::runtime_error("Subgroup arithmetic and ballot not supported in compute shaders.");
+    }
+
     vk::StructureChain<vk::PhysicalDeviceFeatures2,
+                       vk::PhysicalDeviceVulkan12Features,
                        vk::PhysicalDeviceVulkan13Features,
                        vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT> enabledFeatures = {
-        {}, {.synchronization2 = true, .dynamicRendering = true}, {.extendedDynamicState = true}
+        {},
+        {.hostQueryReset = true, .timelineSemaphore = true},
+        {.synchronization2 = true, .dynamicRendering = true},
+        {.extendedDynamicState = true}
     };
 
 
     float queuePriority = 1.0f;
-    vk::DeviceQueueCreateInfo queueCreateInfo{
-        .queueFamilyIndex = graphicsQueueIndex,
-        .queueCount = 1,
-        .pQueuePriorities = &queuePriority
-    };
+    std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
+    for (const uint32_t familyIndex : std::set{graphicsQueueIndex, transferQueueIndex}) {
+        queueCreateInfos.push_back({
+            .queueFamilyIndex = familyIndex,
+            .queueCount = 1,
+            .pQueuePriorities = &queuePriority
+        });
+    }
 
     vk::DeviceCreateInfo deviceCreateInfo{
         .pNext = &enabledFeatures.get<vk::PhysicalDeviceFeatures2>(),
-        .queueCreateInfoCount = 1u,
-        .pQueueCreateInfos = &queueCreateInfo,
+        .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
+        .pQueueCreateInfos = queueCreateInfos.data(),
         .enabledExtensionCount = static_cast<uint32_t>(requiredExtensions.size()),
         .ppEnabledExtensionNames = requiredExtensions.data()
     };
@@ -208,6 +337,7 @@ void VulkanContext::CreateLogicalDevice() {
     device = physicalDevice.createDevice(deviceCreateInfo);
     VULKAN_HPP_DEFAULT_DISPATCHER.init(device);
     graphicsQueue = device.getQueue(graphicsQueueIndex, 0);
+    transferQueue = device.getQueue(transferQueueIndex, 0);
 }
 
 void VulkanContext::CreateDescriptorPool() {
@@ -243,3 +373,57 @@ void VulkanContext::CreateCommandPool() {
 
     commandPool = device.createCommandPool(poolInfo);
 }
+
+void VulkanContext::CreateTimelines() {
+    graphicsTimeline = std::make_unique<Timeline>(device);
+    transferTimeline = std::make_unique<Timeline>(device);
+}
+
+void VulkanContext::CreatePipelineCache() {
+    std::vector<std::byte> initialData;
+
+    if (auto data = File::ReadBinaryFile(File::GetCacheDirectory() / PIPELINE_CACHE_FILE)) {
+        if (IsPipelineCacheCompatible(*data)) {
+            initialData = std::move(*data);
+            LOGI("Loaded pipeline cache ({} bytes)", initialData.size());
+        } else {
+            LOGW("Discarding pipeline cache created by another device or driver");
+        }
+    } else if (data.error().type != File::FileError::Type::NotFound) {
+        LOGW("{}", data.error());
+    }
+
+    const vk::PipelineCacheCreateInfo cacheInfo{
+        .initialDataSize = initialData.size(),
+        .pInitialData = initialData.data(),
+    };
+
+    pipelineCache = device.createPipelineCache(cacheInfo);
+}
+
+void VulkanContext::SavePipelineCache() const {
+    const auto data = device.getPipelineCacheData(pipelineCache);
+
+    const auto path = File::GetCacheDirectory() / PIPELINE_CACHE_FILE;
+    if (const auto result = File::WriteBinaryFile(path, std::as_bytes(std::span(data))); !result) {
+        LOGW("{}", result.error());
+        return;
+    }
+
+    LOGI("Saved pipeline cache to {} ({} bytes)", path.string(), data.size());
+}
+
+bool VulkanContext::IsPipelineCacheCompatible(const std::span<const std::byte> data) const {
+    // Drivers should reject foreign data themselves, but not all of them do it gracefully
+    vk::PipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header)) return false;
+    memcpy(&header, data.data(), sizeof(header));
+
+    const auto properties = physicalDevice.getProperties();
+
+    return header.headerSize >= sizeof(header) &&
+           header.headerVersion == vk::PipelineCacheHeaderVersion::eOne &&
+           header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           header.pipelineCacheUUID == properties.pipelineCacheUUID;
+}
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <deque>
+#include <span>
+#include <functional>
+
 #include "Window/Window.h"
 #include "Vulkan/Base.h"
+#include "Vulkan/Timeline.h"
 
 class VulkanContext {
 public:
+    // A null window creates a headless context: no surface, no swapchain support required
     explicit VulkanContext(const std::shared_ptr<Window>& window);
     ~VulkanContext();
 
@@ -19,21 +25,69 @@ public:
     uint32_t graphicsQueueIndex = -1;
     vk::Queue graphicsQueue = nullptr;
 
+    // Equal to the graphics queue when the device exposes no transfer-only family
+    uint32_t transferQueueIndex = -1;
+    vk::Queue transferQueue = nullptr;
+
+    // Streaming multiprocessors or compute units, 0 when the vendor does not expose the count
+    uint32_t computeUnitCount = 0;
+
     vk::DescriptorPool mainDescriptorPool = nullptr;
     vk::CommandPool commandPool = nullptr;
 
+    // Shared by every pipeline creation, persisted between runs
+    vk::PipelineCache pipelineCache = nullptr;
+
+    // One timeline per queue, values are only signaled in submission order
+    std::unique_ptr<Timeline> graphicsTimeline;
+    std::unique_ptr<Timeline> transferTimeline;
+
 public:
     vk::CommandBuffer BeginSingleTimeCommands() const;
     void EndSingleTimeCommands(vk::CommandBuffer commandBuffer) const;
 
+    bool HasDedicatedTransferQueue() const { return transferQueueIndex != graphicsQueueIndex; }
+    bool IsHeadless() const { return !window; }
+
+    // Counts Vulkan objects created through the wrappers, read back once per frame
+    void TrackCreation(const uint32_t count = 1) const { objectCreations += count; }
+    uint32_t ConsumeObjectCreations() const { return std::exchange(objectCreations, 0); }
+
+    // Runs destroy once every submission made so far, on both queues, has completed
+    void DeferDestruction(std::move_only_function<void()> destroy) const;
+
+    template <typename T>
+    void Retire(T resource) const {
+        DeferDestruction([r = std::move(resource)]() mutable { r.reset(); });
+    }
+
+    void CollectGarbage() const;
+    void FlushDeletions() const;
+
 private:
     void CreateInstance();
     void CreateSurface();
     void PickPhysicalDevice();
+    void PickTransferQueueFamily();
+    void QueryComputeUnits();
     void CreateLogicalDevice();
     void CreateDescriptorPool();
     void CreateCommandPool();
+    void CreateTimelines();
+    void CreatePipelineCache();
+    void SavePipelineCache() const;
+    bool IsPipelineCacheCompatible(std::span<const std::byte> data) const;
 
 private:
     std::shared_ptr<Window> window;
+
+    mutable uint32_t objectCreations = 0;
+
+    struct PendingDeletion {
+        uint64_t graphicsValue;
+        uint64_t transferValue;
+        std::move_only_function<void()> destroy;
+    };
+
+    mutable std::deque<PendingDeletion> pendingDeletions;
 };
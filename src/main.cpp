@@ -1,6 +1,33 @@
 #include "Application.h"
+#include "BenchmarkApplication.h"
+#include "HeadlessApplication.h"
+#include "TraversalBenchmark.h"
+#include "Core/CommandLine.h"
+#include "Core/Log.h"
+#include "Core/Trace.h"
 
-int main(int argc, char** argv) {
-    auto app = Application("Vulkan-RayTracer", 800, 600);
+static int Run(const CommandLine::Options& options) {
+    if (options.headless) return HeadlessApplication(options).Run();
+    if (options.benchmark) return BenchmarkApplication(options).Run();
+    if (options.traversalBenchmark) return TraversalBenchmark(options).Run();
+
+    auto app = Application("Vulkan-RayTracer", options.width, options.height);
     app.Run();
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    const auto options = CommandLine::Parse(argc, argv);
+    if (!options || options->help) {
+        if (!options) LOGE("{}", options.error());
+        std::cout << CommandLine::Usage(argv[0]);
+        return options ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (!options->trace.empty()) Trace::Start();
+
+    const int result = Run(*options);
+
+    if (!options->trace.empty()) Trace::Save(options->trace);
+    return result;
 }